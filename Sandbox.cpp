@@ -1,5 +1,6 @@
 #include "Sandbox.h"
 
+#include "qcpl_colormap.h"
 #include "qcpl_format.h"
 #include "qcpl_io_json.h"
 #include "qcpl_utils.h"
@@ -154,7 +155,7 @@ void PlotWindow::addRandomSampleColormap()
     if (!_colorScale)
         createColorScale();
 
-    auto graph = new QCPColorMap(_plot->xAxis, _plot->yAxis);
+    auto graph = new QCPL::ColorMap(_plot->xAxis, _plot->yAxis);
     graph->setName(OriPetname::make());
     graph->setColorScale(_colorScale);
 
@@ -168,11 +169,7 @@ void PlotWindow::addRandomSampleColormap()
     data->setSize(countX, countY);
     data->setRange({ offsetX, offsetX+countX-1.0 }, { offsetY, offsetY+countY-1.0 });
     for (int y = 0; y < countY; y++)
-    {
-        auto line = QCPL::makeRandomSample(countX);
-        for (int x = 0; x < countX; x++)
-            data->setCell(x, y, line.y[x]);
-    }
+        graph->setRow(y, QCPL::makeRandomSample(countX).y.constData());
     _plot->replot();
 }
 
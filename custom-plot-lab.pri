@@ -15,10 +15,18 @@ SOURCES += \
     $$PWD/qcpl_format_legend.cpp \
     $$PWD/qcpl_format_title.cpp \
     $$PWD/qcpl_io_json.cpp \
+    $$PWD/qcpl_parallel.cpp \
     $$PWD/qcpl_text_editor.cpp \
     $$PWD/qcpl_plot.cpp \
+    $$PWD/qcpl_raster.cpp \
+    $$PWD/qcpl_render.cpp \
+    $$PWD/qcpl_simd.cpp \
+    $$PWD/qcpl_colormap.cpp \
     $$PWD/qcpl_colors.cpp \
     $$PWD/qcpl_graph.cpp \
+    $$PWD/qcpl_graph_data.cpp \
+    $$PWD/qcpl_graph_lod.cpp \
+    $$PWD/qcpl_graph_mapped.cpp \
     $$PWD/qcpl_types.cpp \
     $$PWD/qcpl_graph_grid.cpp \
     $$PWD/qcpl_utils.cpp \
@@ -37,10 +45,18 @@ HEADERS  += \
     $$PWD/qcpl_format_legend.h \
     $$PWD/qcpl_format_title.h \
     $$PWD/qcpl_io_json.h \
+    $$PWD/qcpl_parallel.h \
     $$PWD/qcpl_text_editor.h \
     $$PWD/qcpl_plot.h \
+    $$PWD/qcpl_raster.h \
+    $$PWD/qcpl_render.h \
+    $$PWD/qcpl_simd.h \
+    $$PWD/qcpl_colormap.h \
     $$PWD/qcpl_colors.h \
     $$PWD/qcpl_graph.h \
+    $$PWD/qcpl_graph_data.h \
+    $$PWD/qcpl_graph_lod.h \
+    $$PWD/qcpl_graph_mapped.h \
     $$PWD/qcpl_types.h \
     $$PWD/qcpl_graph_grid.h \
     $$PWD/qcpl_utils.h \
@@ -76,7 +76,7 @@ static void highlightAxes(Plot* plot, const AxisPair& pair)
     foreach (auto axis, plot->axisRect()->axes())
         if (auto a = dynamic_cast<Axis*>(axis); a)
             a->setHightlight(a == pair.x || a == pair.y);
-    plot->replot();
+    plot->scheduleReplot();
 }
 
 class AxesChooser : public QWidget
@@ -0,0 +1,599 @@
+#include "qcpl_colormap.h"
+
+#include "qcpl_parallel.h"
+#include "qcpl_simd.h"
+
+#include <cmath>
+
+namespace QCPL {
+
+/// Scan lines are colorized and pyramid rows are reduced in parallel blocks of about this number of cells
+const int colorizeBlockPixels = 1 << 16;
+
+//------------------------------------------------------------------------------
+//                              ColorMapPyramid
+//------------------------------------------------------------------------------
+
+static inline double reduceCells(ColorMapPyramid::Reduction reduction, double a, double b, double c, double d)
+{
+    double sum = 0, min = qInf(), max = -qInf();
+    int count = 0;
+    for (double v : {a, b, c, d})
+    {
+        if (std::isnan(v)) continue;
+        sum += v;
+        min = qMin(min, v);
+        max = qMax(max, v);
+        count++;
+    }
+    if (count == 0)
+        return qQNaN();
+    switch (reduction)
+    {
+    case ColorMapPyramid::Mean: return sum / count;
+    case ColorMapPyramid::Max: return max;
+    case ColorMapPyramid::Min: return min;
+    }
+    return qQNaN();
+}
+
+void ColorMapPyramid::build(const QCPColorMapData *data, Reduction reduction)
+{
+    _reduction = reduction;
+    _levels.clear();
+    if (data->isEmpty() || !data->rawData()) return;
+
+    int keySize = data->keySize();
+    int valueSize = data->valueSize();
+    while (true)
+    {
+        keySize = (keySize + 1) / 2;
+        valueSize = (valueSize + 1) / 2;
+        // QCPColorMap can't draw a map having a single cell along any of axes
+        if (keySize < 2 || valueSize < 2)
+            break;
+        _levels << Level{keySize, valueSize, QVector<double>(keySize * valueSize)};
+    }
+    update(data, 0, data->valueSize()-1);
+}
+
+void ColorMapPyramid::update(const QCPColorMapData *data, int firstValueIndex, int lastValueIndex)
+{
+    const double *src = data->rawData();
+    int srcKeySize = data->keySize();
+    int srcValueSize = data->valueSize();
+    const double nan = qQNaN();
+    for (Level &level : _levels)
+    {
+        firstValueIndex /= 2;
+        lastValueIndex /= 2;
+        // Get the pointer here, it's not safe to detach the vector from several threads
+        double *dst = level.data.data();
+        const int rowsPerBlock = qMax(1, colorizeBlockPixels / level.keySize);
+        const int blockCount = (lastValueIndex - firstValueIndex + rowsPerBlock) / rowsPerBlock;
+        runParallel(blockCount, [&](int block){
+            const int begin = firstValueIndex + block*rowsPerBlock;
+            const int end = qMin(begin + rowsPerBlock, lastValueIndex + 1);
+            for (int row = begin; row < end; row++)
+            {
+                // Odd-sized levels have the last row and column without pairs
+                const double *src0 = src + 2*row*srcKeySize;
+                const double *src1 = 2*row + 1 < srcValueSize ? src0 + srcKeySize : nullptr;
+                double *cells = dst + row*level.keySize;
+                for (int k = 0; k < level.keySize; k++)
+                {
+                    const int k0 = 2*k;
+                    const bool pair = k0 + 1 < srcKeySize;
+                    cells[k] = reduceCells(_reduction, src0[k0], pair ? src0[k0+1] : nan,
+                        src1 ? src1[k0] : nan, src1 && pair ? src1[k0+1] : nan);
+                }
+            }
+        });
+        src = level.data.constData();
+        srcKeySize = level.keySize;
+        srcValueSize = level.valueSize;
+    }
+}
+
+//------------------------------------------------------------------------------
+//                                 ColorMap
+//------------------------------------------------------------------------------
+
+ColorMap::ColorMap(QCPAxis *keyAxis, QCPAxis *valueAxis) : QCPColorMap(keyAxis, valueAxis),
+    _view(2, 2, QCPRange(0, 1), QCPRange(0, 1))
+{
+}
+
+void ColorMap::setRow(int valueIndex, const double *values)
+{
+    if (valueIndex < 0 || valueIndex >= mMapData->valueSize())
+    {
+        qWarning() << Q_FUNC_INFO << "index out of bounds:" << valueIndex;
+        return;
+    }
+    const bool modified = mMapData->isDataModified();
+    const int keySize = mMapData->keySize();
+    for (int i = 0; i < keySize; i++)
+        mMapData->setCell(i, valueIndex, values[i]);
+    // setCell() marks the whole data as modified, it only makes sense to narrow it when nothing else was changed
+    if (!modified)
+        invalidateRows(valueIndex, valueIndex);
+}
+
+void ColorMap::invalidateRows(int firstValueIndex, int lastValueIndex)
+{
+    firstValueIndex = qMax(firstValueIndex, 0);
+    lastValueIndex = qMin(lastValueIndex, mMapData->valueSize()-1);
+    if (firstValueIndex > lastValueIndex) return;
+
+    mMapData->setDataModified(false);
+    if (_dirtyFirst > _dirtyLast)
+    {
+        _dirtyFirst = firstValueIndex;
+        _dirtyLast = lastValueIndex;
+    }
+    else
+    {
+        _dirtyFirst = qMin(_dirtyFirst, firstValueIndex);
+        _dirtyLast = qMax(_dirtyLast, lastValueIndex);
+    }
+}
+
+void ColorMap::setMipmapsEnabled(bool on)
+{
+    _mipmapsEnabled = on;
+    _pyramid.clear();
+    _pyramidValid = false;
+}
+
+void ColorMap::setMipmapReduction(ColorMapPyramid::Reduction reduction)
+{
+    if (_mipmapReduction == reduction) return;
+    _mipmapReduction = reduction;
+    _pyramidValid = false;
+}
+
+void ColorMap::draw(QCPPainter *painter)
+{
+    if (mMapData->isEmpty()) return;
+    if (!mKeyAxis || !mValueAxis) return;
+
+    if (_mipmapsEnabled && !mMapData->rawAlpha() && mMapData->rawData())
+    {
+        drawMipmap(painter);
+        return;
+    }
+    // The pyramid misses rows changed since now
+    _pyramidValid = false;
+    if (_imageOfView)
+    {
+        mMapImageInvalidated = true;
+        _imageOfView = false;
+    }
+    // QCPColorMap::draw() only updates the image when the whole data is modified
+    if (_dirtyFirst <= _dirtyLast)
+        updateMapImage();
+    QCPColorMap::draw(painter);
+}
+
+void ColorMap::drawMipmap(QCPPainter *painter)
+{
+    // New data objects are always created modified, so the flag also tracks data replacement via setData()
+    bool viewInvalidated = !_imageOfView;
+    if (!_pyramidValid || mMapData->isDataModified())
+    {
+        _pyramid.build(mMapData, _mipmapReduction);
+        _pyramidValid = true;
+        viewInvalidated = true;
+    }
+    else if (_dirtyFirst <= _dirtyLast)
+    {
+        _pyramid.update(mMapData, _dirtyFirst, _dirtyLast);
+        viewInvalidated = true;
+    }
+    _dirtyFirst = 0;
+    _dirtyLast = -1;
+    mMapData->setDataModified(false);
+
+    // Visible cells of the map with a margin of one cell
+    const int keySize = mMapData->keySize();
+    const int valueSize = mMapData->valueSize();
+    const QCPRange keyRange = mMapData->keyRange();
+    const QCPRange valueRange = mMapData->valueRange();
+    auto cellIndex = [](double coord, const QCPRange &range, int size) {
+        return size > 1 ? (coord - range.lower) / (range.upper - range.lower) * (size-1) : 0.0;
+    };
+    auto cellBounds = [&cellIndex](const QCPRange &axisRange, const QCPRange &range, int size, int &first, int &last) {
+        const double a = cellIndex(axisRange.lower, range, size);
+        const double b = cellIndex(axisRange.upper, range, size);
+        // Bounded in doubles, the indices can be huge when the map is far out of view
+        first = int(qBound(0.0, std::floor(qMin(a, b)) - 1, size-1.0));
+        last = int(qBound(0.0, std::ceil(qMax(a, b)) + 1, size-1.0));
+    };
+    int keyFirst, keyLast, valueFirst, valueLast;
+    cellBounds(mKeyAxis->range(), keyRange, keySize, keyFirst, keyLast);
+    cellBounds(mValueAxis->range(), valueRange, valueSize, valueFirst, valueLast);
+
+    // The coarsest level still having at least one cell per pixel along both axes
+    auto cellCoord = [](double index, const QCPRange &range, int size) {
+        return size > 1 ? index / (size-1) * (range.upper - range.lower) + range.lower : range.lower;
+    };
+    const double keyPixels = qAbs(mKeyAxis->coordToPixel(cellCoord(keyLast, keyRange, keySize)) -
+                                  mKeyAxis->coordToPixel(cellCoord(keyFirst, keyRange, keySize)));
+    const double valuePixels = qAbs(mValueAxis->coordToPixel(cellCoord(valueLast, valueRange, valueSize)) -
+                                    mValueAxis->coordToPixel(cellCoord(valueFirst, valueRange, valueSize)));
+    const double cellsPerPixel = qMin((keyLast - keyFirst + 1) / qMax(1.0, keyPixels),
+                                      (valueLast - valueFirst + 1) / qMax(1.0, valuePixels));
+    const int level = cellsPerPixel >= 2 ? qMin(int(std::log2(cellsPerPixel)), _pyramid.levelCount()-1) : 0;
+
+    int levelKeySize = keySize, levelValueSize = valueSize;
+    if (level > 0)
+    {
+        levelKeySize = _pyramid.level(level).keySize;
+        levelValueSize = _pyramid.level(level).valueSize;
+    }
+    auto levelBounds = [level](int &first, int &last, int size) {
+        first >>= level;
+        last >>= level;
+        // QCPColorMap can't draw a single cell, its size is derived from distance between cells
+        if (first == last)
+        {
+            if (last + 1 < size) last++;
+            else if (first > 0) first--;
+        }
+    };
+    levelBounds(keyFirst, keyLast, levelKeySize);
+    levelBounds(valueFirst, valueLast, levelValueSize);
+    const QRect cells(QPoint(keyFirst, valueFirst), QPoint(keyLast, valueLast));
+
+    if (viewInvalidated || level != _viewLevel || cells != _viewCells)
+        updateView(level, cells);
+
+    // QCPColorMap draws and colorizes whatever mMapData points to, so the view is drawn in place of the map
+    QCPColorMapData *data = mMapData;
+    mMapData = &_view;
+    QCPColorMap::draw(painter);
+    mMapData = data;
+}
+
+/// Copies cells of the pyramid level into the view and places the view at their coordinates in the map.
+void ColorMap::updateView(int level, const QRect &cells)
+{
+    const double *src = mMapData->rawData();
+    int srcKeySize = mMapData->keySize();
+    if (level > 0)
+    {
+        src = _pyramid.level(level).data.constData();
+        srcKeySize = _pyramid.level(level).keySize;
+    }
+
+    // Centers of level cells in map cell indices, the last level cells can stick out the map by less than a cell
+    const int keySize = mMapData->keySize();
+    const int valueSize = mMapData->valueSize();
+    const QCPRange keyRange = mMapData->keyRange();
+    const QCPRange valueRange = mMapData->valueRange();
+    const double cellSize = 1 << level;
+    auto cellCoord = [cellSize](int levelIndex, const QCPRange &range, int size) {
+        const double index = levelIndex*cellSize + (cellSize - 1) / 2;
+        return size > 1 ? index / (size-1) * (range.upper - range.lower) + range.lower : range.lower;
+    };
+
+    _view.setSize(cells.width(), cells.height());
+    _view.setRange(QCPRange(cellCoord(cells.left(), keyRange, keySize), cellCoord(cells.right(), keyRange, keySize)),
+                   QCPRange(cellCoord(cells.top(), valueRange, valueSize), cellCoord(cells.bottom(), valueRange, valueSize)));
+    for (int v = 0; v < cells.height(); v++)
+    {
+        const double *row = src + (cells.top() + v)*srcKeySize + cells.left();
+        for (int k = 0; k < cells.width(); k++)
+            _view.setCell(k, v, row[k]);
+    }
+    // The view image is recolorized by QCPColorMap::draw() because setCell() marks the view as modified
+    _view.setDataModified(true);
+    _viewLevel = level;
+    _viewCells = cells;
+    _imageOfView = true;
+}
+
+void ColorMap::updateMapImage()
+{
+    QCPAxis *keyAxis = mKeyAxis.data();
+    if (!keyAxis) return;
+    if (mMapData->isEmpty()) return;
+
+    // The image layout is the same as in QCPColorMap::updateMapImage():
+    // scan lines go along the key axis (along the value axis when the key axis is vertical),
+    // and small maps are colorized into mUndersampledMapImage and then scaled to have at least 100 pixels
+    const QImage::Format format = QImage::Format_ARGB32_Premultiplied;
+    const int keySize = mMapData->keySize();
+    const int valueSize = mMapData->valueSize();
+    const bool keyVertical = keyAxis->orientation() == Qt::Vertical;
+    const int keyOversamplingFactor = mInterpolate ? 1 : int(1.0+100.0/double(keySize));
+    const int valueOversamplingFactor = mInterpolate ? 1 : int(1.0+100.0/double(valueSize));
+    const bool oversampling = keyOversamplingFactor > 1 || valueOversamplingFactor > 1;
+    const QSize size = keyVertical ? QSize(valueSize, keySize) : QSize(keySize, valueSize);
+    const QSize imageSize = keyVertical
+        ? QSize(valueSize*valueOversamplingFactor, keySize*keyOversamplingFactor)
+        : QSize(keySize*keyOversamplingFactor, valueSize*valueOversamplingFactor);
+
+    bool full = mMapImageInvalidated || mMapData->isDataModified() || _imageOrientation != keyAxis->orientation();
+    if (mMapImage.size() != imageSize)
+    {
+        mMapImage = QImage(imageSize, format);
+        full = true;
+    }
+    if (mMapImage.isNull())
+    {
+        qWarning() << Q_FUNC_INFO << "Couldn't create map image (possibly too large for memory)";
+        mMapImage = QImage(QSize(10, 10), format);
+        mMapImage.fill(Qt::black);
+    }
+    else
+    {
+        QImage *image = &mMapImage;
+        if (oversampling)
+        {
+            if (mUndersampledMapImage.size() != size)
+            {
+                mUndersampledMapImage = QImage(size, format);
+                full = true;
+            }
+            image = &mUndersampledMapImage;
+        }
+        else if (!mUndersampledMapImage.isNull())
+            mUndersampledMapImage = QImage();
+
+        if (full)
+            colorize(*image, 0, size.height()-1, 0, size.width()-1, keyVertical);
+        else if (_dirtyFirst <= _dirtyLast)
+        {
+            // Data rows are scan lines when the key axis is horizontal and pixel columns otherwise
+            if (keyVertical)
+                colorize(*image, 0, size.height()-1, _dirtyFirst, _dirtyLast, keyVertical);
+            else
+                colorize(*image, _dirtyFirst, _dirtyLast, 0, size.width()-1, keyVertical);
+        }
+
+        if (oversampling)
+            mMapImage = mUndersampledMapImage.scaled(imageSize, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+    }
+    _imageOrientation = keyAxis->orientation();
+    _dirtyFirst = 0;
+    _dirtyLast = -1;
+    mMapData->setDataModified(false);
+    mMapImageInvalidated = false;
+}
+
+/// Colorizes pixels [firstPixel, lastPixel] of lines [firstLine, lastLine], lines are counted from the image bottom.
+/// A line is a data row (all keys of a value index) when the key axis is horizontal, and a data column otherwise.
+void ColorMap::colorize(QImage &image, int firstLine, int lastLine, int firstPixel, int lastPixel, bool keyVertical)
+{
+    const double *data = mMapData->rawData();
+    const unsigned char *alpha = mMapData->rawAlpha();
+    const int lineCount = image.height();
+    const int lineStep = keyVertical ? 1 : image.width();
+    const int pixelStep = keyVertical ? lineCount : 1;
+    const int pixelCount = lastPixel - firstPixel + 1;
+    const bool logarithmic = mDataScaleType == QCPAxis::stLogarithmic;
+
+    // The lookup is equivalent to QCPColorGradient::colorize() for linear non-periodic gradients,
+    // the table is the gradient's own color buffer got by colorizing the ramp of level indices
+    const bool useLookup = !logarithmic && !alpha && !mGradient.periodic();
+    QVector<QRgb> lut;
+    QRgb nanColor = 0;
+    if (useLookup)
+    {
+        const int levelCount = mGradient.levelCount();
+        QVector<double> ramp(levelCount);
+        for (int i = 0; i < levelCount; i++)
+            ramp[i] = i;
+        lut.resize(levelCount);
+        mGradient.colorize(ramp.constData(), QCPRange(0, levelCount-1), lut.data(), levelCount);
+        if (mGradient.nanHandling() != QCPColorGradient::nhNone)
+        {
+            const double nan = qQNaN();
+            mGradient.colorize(&nan, QCPRange(0, 1), &nanColor, 1);
+        }
+    }
+    else
+    {
+        // Threads call colorize() of the same gradient, so its color buffer must be ready and not shared
+        // with other gradient copies, otherwise non-const access to the buffer would detach it concurrently.
+        // Resetting stops makes the gradient rebuild its buffer, it takes only a few hundred colors.
+        mGradient.setColorStops(mGradient.colorStops());
+        const double zero = 0;
+        QRgb color;
+        mGradient.colorize(&zero, QCPRange(0, 1), &color, 1);
+    }
+    const double lower = mDataRange.lower;
+    const double factor = (lut.size()-1) / mDataRange.size();
+
+    // Pixels are accessed via raw bits because QImage::scanLine() is not safe to call from several threads
+    uchar *bits = image.bits();
+    const auto bytesPerLine = image.bytesPerLine();
+    const int linesPerBlock = qMax(1, colorizeBlockPixels / pixelCount);
+    const int blockCount = (lastLine - firstLine + linesPerBlock) / linesPerBlock;
+    runParallel(blockCount, [&](int block){
+        const int begin = firstLine + block*linesPerBlock;
+        const int end = qMin(begin + linesPerBlock, lastLine + 1);
+        for (int line = begin; line < end; line++)
+        {
+            // QImage counts scan lines from top, but value indices count from bottom
+            QRgb *pixels = reinterpret_cast<QRgb*>(bits + (lineCount-1-line)*bytesPerLine) + firstPixel;
+            const int offset = line*lineStep + firstPixel*pixelStep;
+            if (useLookup)
+                lookupColors(data + offset, pixelCount, pixelStep, lower, factor, lut.constData(), lut.size(), nanColor, pixels);
+            else if (alpha)
+                mGradient.colorize(data + offset, alpha + offset, mDataRange, pixels, pixelCount, pixelStep, logarithmic);
+            else
+                mGradient.colorize(data + offset, mDataRange, pixels, pixelCount, pixelStep, logarithmic);
+        }
+    });
+}
+
+//------------------------------------------------------------------------------
+//                                WaterfallMap
+//------------------------------------------------------------------------------
+
+WaterfallMap::WaterfallMap(QCPAxis *keyAxis, QCPAxis *valueAxis) : QCPColorMap(keyAxis, valueAxis)
+{
+}
+
+void WaterfallMap::setSize(int rowSize, int rowCount)
+{
+    mMapData->setSize(rowSize, rowCount);
+    clear();
+}
+
+void WaterfallMap::clear()
+{
+    mMapData->fill(0);
+    _head = 0;
+    _pendingRows = 0;
+}
+
+void WaterfallMap::appendRow(const double *values)
+{
+    if (mMapData->isEmpty()) return;
+
+    // The size could be changed via data() directly
+    if (_head >= rowCount())
+        _head = 0;
+
+    const bool modified = mMapData->isDataModified();
+    const int size = rowSize();
+    for (int i = 0; i < size; i++)
+        mMapData->setCell(i, _head, values[i]);
+    // setCell() marks the whole data as modified, while only this row has to be colorized
+    if (!modified)
+        mMapData->setDataModified(false);
+
+    _head = (_head + 1) % rowCount();
+    _pendingRows = qMin(_pendingRows + 1, rowCount());
+}
+
+int WaterfallMap::newestSlot() const
+{
+    const int count = rowCount();
+    return count > 0 ? (_head + count - 1) % count : 0;
+}
+
+void WaterfallMap::updateMapImage()
+{
+    QCPAxis *keyAxis = mKeyAxis.data();
+    if (!keyAxis) return;
+    if (mMapData->isEmpty()) return;
+
+    // Rows are scan lines in the same order as in QCPColorMap::updateMapImage() (slot 0 is at the bottom)
+    // when the key axis is horizontal, and pixel columns otherwise. Small maps are not oversampled.
+    const bool keyVertical = keyAxis->orientation() == Qt::Vertical;
+    const QSize size = keyVertical ? QSize(rowCount(), rowSize()) : QSize(rowSize(), rowCount());
+    bool full = mMapImageInvalidated || mMapData->isDataModified() || _imageOrientation != keyAxis->orientation();
+    if (mMapImage.size() != size)
+    {
+        mMapImage = QImage(size, QImage::Format_ARGB32_Premultiplied);
+        full = true;
+    }
+    if (mMapImage.isNull())
+    {
+        qWarning() << Q_FUNC_INFO << "Couldn't create map image (possibly too large for memory)";
+        mMapImage = QImage(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+        mMapImage.fill(Qt::black);
+    }
+    else
+    {
+        QVector<QRgb> line(rowSize());
+        const int count = rowCount();
+        if (full)
+        {
+            for (int slot = 0; slot < count; slot++)
+                colorizeRow(slot, keyVertical, line);
+        }
+        else
+        {
+            for (int i = 0; i < _pendingRows; i++)
+                colorizeRow((_head + count - 1 - i) % count, keyVertical, line);
+        }
+    }
+    _imageOrientation = keyAxis->orientation();
+    _pendingRows = 0;
+    mMapData->setDataModified(false);
+    mMapImageInvalidated = false;
+}
+
+void WaterfallMap::colorizeRow(int slot, bool keyVertical, QVector<QRgb> &line)
+{
+    const int size = rowSize();
+    const double *data = mMapData->rawData() + slot*size;
+    const unsigned char *alpha = mMapData->rawAlpha();
+    const bool logarithmic = mDataScaleType == QCPAxis::stLogarithmic;
+    // Rows are colorized directly into scan lines, and via the line buffer into columns
+    QRgb *pixels = keyVertical ? line.data() : reinterpret_cast<QRgb*>(mMapImage.scanLine(rowCount()-1-slot));
+    if (alpha)
+        mGradient.colorize(data, alpha + slot*size, mDataRange, pixels, size, 1, logarithmic);
+    else
+        mGradient.colorize(data, mDataRange, pixels, size, 1, logarithmic);
+    if (keyVertical)
+    {
+        // Key indices go from the image bottom, like in QCPColorMap
+        for (int i = 0; i < size; i++)
+            reinterpret_cast<QRgb*>(mMapImage.scanLine(size-1-i))[slot] = pixels[i];
+    }
+}
+
+void WaterfallMap::draw(QCPPainter *painter)
+{
+    if (mMapData->isEmpty()) return;
+    if (!mKeyAxis || !mValueAxis) return;
+    applyDefaultAntialiasingHint(painter);
+
+    if (mMapData->isDataModified() || mMapImageInvalidated || _pendingRows > 0)
+        updateMapImage();
+
+    // The same image rect as in QCPColorMap::draw(), the outer cells are centered on the data range bounds
+    const bool keyVertical = mKeyAxis->orientation() == Qt::Vertical;
+    const QCPRange keyRange = mMapData->keyRange();
+    const QCPRange valueRange = mMapData->valueRange();
+    const QRectF centersRect = QRectF(coordsToPixels(keyRange.lower, valueRange.lower),
+                                      coordsToPixels(keyRange.upper, valueRange.upper)).normalized();
+    const int widthCells = keyVertical ? rowCount() : rowSize();
+    const int heightCells = keyVertical ? rowSize() : rowCount();
+    const double halfCellWidth = widthCells > 1 ? 0.5*centersRect.width()/double(widthCells-1) : 0;
+    const double halfCellHeight = heightCells > 1 ? 0.5*centersRect.height()/double(heightCells-1) : 0;
+    const QRectF imageRect = centersRect.adjusted(-halfCellWidth, -halfCellHeight, halfCellWidth, halfCellHeight);
+    const bool mirrorX = (keyVertical ? mValueAxis : mKeyAxis)->rangeReversed();
+    const bool mirrorY = (keyVertical ? mKeyAxis : mValueAxis)->rangeReversed();
+
+    painter->save();
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, mInterpolate);
+    if (mTightBoundary)
+        painter->setClipRect(centersRect, Qt::IntersectClip);
+    // Mirrored by the painter rather than by QImage::mirrored(), which would copy the whole image every frame
+    if (mirrorX || mirrorY)
+    {
+        painter->translate(imageRect.center());
+        painter->scale(mirrorX ? -1 : 1, mirrorY ? -1 : 1);
+        painter->translate(-imageRect.center());
+    }
+
+    // Rows stay in their slots, so the oldest row is somewhere in the middle of the image.
+    // The image is painted in two parts, slots from the oldest row on and slots before it,
+    // shifted so that the oldest row is at the lower value bound.
+    const int count = rowCount();
+    const int shift = keyVertical ? (count - _head) % count : _head % count;
+    const double lineSize = (keyVertical ? imageRect.width() : imageRect.height()) / count;
+    auto drawLines = [&](int first, int lineCount) {
+        if (lineCount <= 0) return;
+        const double target = (first + shift) % count * lineSize;
+        if (keyVertical)
+            painter->drawImage(QRectF(imageRect.left() + target, imageRect.top(), lineCount*lineSize, imageRect.height()),
+                               mMapImage, QRectF(first, 0, lineCount, mMapImage.height()));
+        else
+            painter->drawImage(QRectF(imageRect.left(), imageRect.top() + target, imageRect.width(), lineCount*lineSize),
+                               mMapImage, QRectF(0, first, mMapImage.width(), lineCount));
+    };
+    drawLines(0, count - shift);
+    drawLines(count - shift, shift);
+    painter->restore();
+}
+
+} // namespace QCPL
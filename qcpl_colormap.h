@@ -0,0 +1,155 @@
+#ifndef QCPL_COLORMAP_H
+#define QCPL_COLORMAP_H
+
+#include "qcustomplot/qcustomplot.h"
+
+namespace QCPL {
+
+/**
+    Multi-resolution pyramid of color map data.
+
+    Every cell of level N reduces a block of up to 2x2 cells of level N-1, level 0 is the map data itself
+    and is not stored. NaN cells are skipped by the reduction. Levels go while they have at least two cells
+    along both keys and values, so the pyramid takes about 1/3 of the map data memory.
+*/
+class ColorMapPyramid
+{
+public:
+    enum Reduction
+    {
+        Mean,
+        Max,
+        Min,
+    };
+
+    struct Level
+    {
+        int keySize;
+        int valueSize;
+        QVector<double> data;
+    };
+
+    bool isEmpty() const { return _levels.isEmpty(); }
+
+    /// Number of levels including the map data itself
+    int levelCount() const { return _levels.size() + 1; }
+
+    /// Returns the level with @a index >= 1
+    const Level& level(int index) const { return _levels.at(index-1); }
+
+    void build(const QCPColorMapData *data, Reduction reduction);
+
+    /// Recalculates cells of all levels covering data rows [@a firstValueIndex, @a lastValueIndex].
+    void update(const QCPColorMapData *data, int firstValueIndex, int lastValueIndex);
+
+    void clear() { _levels.clear(); }
+
+private:
+    Reduction _reduction = Mean;
+    QVector<Level> _levels;
+};
+
+/**
+    Color map colorizing its image by several threads.
+
+    The image is split into blocks of scan lines colorized in parallel. Linear non-periodic gradients
+    without cell alpha are colorized via a lookup table, see lookupColors(), others via QCPColorGradient::colorize().
+    The image is kept between replots. Gradient, data range or scale changes and QCPColorMapData changes
+    recolorize the whole image, while rows changed via setRow() or marked by invalidateRows() are recolorized alone.
+*/
+class ColorMap : public QCPColorMap
+{
+public:
+    explicit ColorMap(QCPAxis *keyAxis, QCPAxis *valueAxis);
+
+    /// Sets values of the data row with @a valueIndex, @a values should contain data()->keySize() items.
+    void setRow(int valueIndex, const double *values);
+
+    /// Marks rows [@a firstValueIndex, @a lastValueIndex] as changed after their cells have been set via data()->setCell().
+    /// The caller guarantees that no other cells were changed since the last replot.
+    void invalidateRows(int firstValueIndex, int lastValueIndex);
+
+    /// When enabled, the map keeps a pyramid of downsampled data (see ColorMapPyramid) and colorizes
+    /// only the part of the coarsest level still giving at least one cell per pixel that covers the visible area.
+    /// Then the image size depends on the axis rect size rather than on the map size.
+    /// Maps with cell alpha are drawn the usual way. The pyramid is built on the first draw.
+    bool mipmapsEnabled() const { return _mipmapsEnabled; }
+    void setMipmapsEnabled(bool on);
+
+    /// How cells of the map are reduced into cells of coarser mipmap levels, Mean by default.
+    ColorMapPyramid::Reduction mipmapReduction() const { return _mipmapReduction; }
+    void setMipmapReduction(ColorMapPyramid::Reduction reduction);
+
+protected:
+    void draw(QCPPainter *painter) override;
+    void updateMapImage() override;
+
+private:
+    // Range of value indices changed since the last image update, empty when first > last
+    int _dirtyFirst = 0;
+    int _dirtyLast = -1;
+    Qt::Orientation _imageOrientation = Qt::Horizontal;
+
+    bool _mipmapsEnabled = false;
+    ColorMapPyramid::Reduction _mipmapReduction = ColorMapPyramid::Mean;
+    ColorMapPyramid _pyramid;
+    bool _pyramidValid = false;
+
+    // Visible part of a pyramid level, it's drawn in place of the map data in mipmap mode
+    QCPColorMapData _view;
+    int _viewLevel = -1;
+    QRect _viewCells;
+    bool _imageOfView = false;
+
+    void drawMipmap(QCPPainter *painter);
+    void updateView(int level, const QRect &cells);
+    void colorize(QImage &image, int firstLine, int lastLine, int firstPixel, int lastPixel, bool keyVertical);
+};
+
+/**
+    Waterfall (spectrogram) map of rows streamed one by one.
+
+    Rows go along the key axis and the value axis is time: the newest row is drawn at the upper bound
+    of the data value range and the oldest one at the lower bound. Rows are kept in QCPColorMapData
+    as in a circular buffer, so value indices of data() are ring slots rather than row ages, see newestSlot().
+    appendRow() costs O(rowSize()): only the new row is colorized into the persistent image on the next replot,
+    and the image is scrolled by painting it in two parts split at the oldest row instead of shifting it.
+    Gradient, data range or scale changes recolorize the whole image.
+*/
+class WaterfallMap : public QCPColorMap
+{
+public:
+    explicit WaterfallMap(QCPAxis *keyAxis, QCPAxis *valueAxis);
+
+    int rowSize() const { return mMapData->keySize(); }
+    int rowCount() const { return mMapData->valueSize(); }
+
+    /// Resizes the buffer to @a rowCount rows of @a rowSize cells each and clears it.
+    void setSize(int rowSize, int rowCount);
+
+    /// Appends a row of rowSize() values replacing the oldest one.
+    void appendRow(const double *values);
+
+    /// Value index in data() of the most recently appended row.
+    int newestSlot() const;
+
+    /// Fills all the rows with zeros.
+    void clear();
+
+protected:
+    void draw(QCPPainter *painter) override;
+    void updateMapImage() override;
+
+private:
+    // Slot for the next row, it holds the oldest row
+    int _head = 0;
+    // Rows appended since the last image update
+    int _pendingRows = 0;
+    Qt::Orientation _imageOrientation = Qt::Horizontal;
+
+    void colorizeRow(int slot, bool keyVertical, QVector<QRgb> &line);
+};
+
+} // namespace QCPL
+
+#endif // QCPL_COLORMAP_H
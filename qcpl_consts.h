@@ -1,7 +1,6 @@
 #ifndef QCPL_CONSTS_H
 #define QCPL_CONSTS_H
 
-#define PROP_GRAPH_IS_CURSOR "ori-graph-is-cursor"
 #define PROP_GRAPH_SKIP_CLICKS "ori-graph-skip-clicks"
 #define PROP_GRAPH_DONT_COUNT "ori-graph-dont-count"
 
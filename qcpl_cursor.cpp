@@ -1,40 +1,77 @@
 #include "qcpl_cursor.h"
 
-#include "qcpl_consts.h"
-
 #include <QApplication>
 
 namespace QCPL {
 
-Cursor::Cursor(QCustomPlot *plot) : QCPGraph(plot->xAxis, plot->yAxis)
+static QString cursorLayer(QCustomPlot *plot)
+{
+    // Cursor moves much more often than anything else changes,
+    // so it gets a buffered layer to be repainted alone, above graphs and axes
+    const QString name = QStringLiteral("cursor");
+    if (!plot->layer(name))
+    {
+        plot->addLayer(name, plot->layer(QStringLiteral("axes")), QCustomPlot::limAbove);
+        plot->layer(name)->setMode(QCPLayer::lmBuffered);
+    }
+    return name;
+}
+
+Cursor::Cursor(QCustomPlot *plot) : QCPLayerable(plot, cursorLayer(plot)),
+    _keyAxis(plot->xAxis), _valueAxis(plot->yAxis),
+    _pen(QColor::fromRgb(80, 80, 255)) // TODO make customizable
 {
     setAntialiased(false);
-    setPen(QPen(QColor::fromRgb(80, 80, 255))); // TODO make customizable
-    setProperty(PROP_GRAPH_IS_CURSOR, true);
-    setProperty(PROP_GRAPH_DONT_COUNT, true);
 
     connect(plot, SIGNAL(emptySpaceDoubleClicked(QMouseEvent*)), this, SLOT(mouseDoubleClick(QMouseEvent*)));
     connect(plot, SIGNAL(mousePress(QMouseEvent*)), this, SLOT(mousePress(QMouseEvent*)));
     connect(plot, SIGNAL(mouseRelease(QMouseEvent*)), this, SLOT(mouseRelease(QMouseEvent*)));
     connect(plot, SIGNAL(mouseMove(QMouseEvent*)), this, SLOT(mouseMove(QMouseEvent*)));
+}
 
-    removeFromLegend();
-    setPosition(0, 0);
-
-    auto axesLayer = plot->layer(QStringLiteral("axes"));
-    if (axesLayer) setLayer(axesLayer);
+void Cursor::replotLayer()
+{
+    // Falls back to full replot when layers have been changed since the last one
+    if (mLayer)
+        mLayer->replot();
+    else parentPlot()->replot();
 }
 
 void Cursor::setVisible(bool on)
 {
-    QCPGraph::setVisible(on);
-    parentPlot()->replot();
+    QCPLayerable::setVisible(on);
+    replotLayer();
+}
+
+void Cursor::setPen(const QPen& pen)
+{
+    _pen = pen;
+    replotLayer();
 }
 
 void Cursor::setShape(CursorShape value)
 {
     _shape = value;
-    parentPlot()->replot();
+    replotLayer();
+}
+
+double Cursor::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const
+{
+    Q_UNUSED(details)
+    // The cursor is not selectable, so it must not take selection clicks from graphs under its lines.
+    // Mouse press and double click are dispatched with onlySelectable=false and still reach it.
+    if (onlySelectable)
+        return -1;
+    if (!_keyAxis || !_valueAxis || !clipRect().contains(pos.toPoint()))
+        return -1;
+    double x, y;
+    pixelPosition(x, y);
+    double dist = std::numeric_limits<double>::max();
+    if (_shape == HorizontalLine || _shape == CrossLines)
+        dist = qAbs(pos.y() - y);
+    if (_shape == VerticalLine || _shape == CrossLines)
+        dist = qMin(dist, qAbs(pos.x() - x));
+    return dist <= mParentPlot->selectionTolerance() ? dist : -1;
 }
 
 void Cursor::mouseDoubleClickEvent(QMouseEvent *event, const QVariant &details)
@@ -125,9 +162,23 @@ void Cursor::mouseMove(QMouseEvent *evt)
     }
 }
 
+QRect Cursor::clipRect() const
+{
+    if (_keyAxis)
+        return _keyAxis->axisRect()->rect();
+    return QRect();
+}
+
+void Cursor::applyDefaultAntialiasingHint(QCPPainter *painter) const
+{
+    applyAntialiasingHint(painter, mAntialiased, QCP::aePlottables);
+}
+
 void Cursor::draw(QCPPainter *painter)
 {
-    painter->setPen(mPen);
+    if (!_keyAxis || !_valueAxis) return;
+
+    painter->setPen(_pen);
     painter->setBrush(Qt::NoBrush);
 
     double x, y;
@@ -139,31 +190,30 @@ void Cursor::draw(QCPPainter *painter)
         painter->drawLine(QPointF(x, r->bottom()), QPointF(x, r->top()));
 }
 
-QPointF Cursor::position() const
-{
-    auto point = data()->constBegin();
-    return QPointF(point->key, point->value);
-}
-
 void Cursor::setPosition(const double& x, const double& y, bool replot)
 {
-    setData(QVector<double>() << x, QVector<double>() << y);
+    _x = x;
+    _y = y;
     if (replot)
-        parentPlot()->replot();
+        replotLayer();
     emit positionChanged();
 }
 
 void Cursor::pixelPosition(double& x, double& y) const
 {
-    QPointF point = position();
-    coordsToPixels(point.x(), point.y(), x, y);
+    if (!_keyAxis || !_valueAxis)
+    {
+        x = y = 0;
+        return;
+    }
+    x = _keyAxis->coordToPixel(_x);
+    y = _valueAxis->coordToPixel(_y);
 }
 
 void Cursor::setPixelPosition(const double &x, const double &y, bool replot)
 {
-    double key, value;
-    pixelsToCoords(x, y, key, value);
-    setPosition(key, value, replot);
+    if (!_keyAxis || !_valueAxis) return;
+    setPosition(_keyAxis->pixelToCoord(x), _valueAxis->pixelToCoord(y), replot);
 }
 
 void Cursor::moveToCenter(bool replot)
@@ -5,7 +5,13 @@
 
 namespace QCPL {
 
-class Cursor : public QCPGraph
+/**
+    Plot cursor drawn as lines over the axis rect.
+
+    The cursor lives on its own buffered layer and keeps its position in plain members,
+    so moving it only repaints that layer and doesn't touch any graph data.
+*/
+class Cursor : public QCPLayerable
 {
     Q_OBJECT
 
@@ -14,7 +20,11 @@ public:
 
 public:
     explicit Cursor(QCustomPlot *plot);
-    QPointF position() const;
+    QCPAxis* keyAxis() const { return _keyAxis.data(); }
+    QCPAxis* valueAxis() const { return _valueAxis.data(); }
+    QPen pen() const { return _pen; }
+    void setPen(const QPen& pen);
+    QPointF position() const { return QPointF(_x, _y); }
     void setPosition(const double& x, const double& y, bool replot = true);
     void setPosition(const QPointF& pos, bool replot = true) { setPosition(pos.x(), pos.y(), replot); }
     void setPositionX(const double& x, bool replot = true) { setPosition(x, position().y(), replot); }
@@ -27,6 +37,7 @@ public:
     bool followMouse() const { return _followMouse; }
     CursorShape shape() const { return _shape; }
     void setShape(CursorShape value);
+    double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details = nullptr) const override;
 
 public slots:
     void setFollowMouse(bool value);
@@ -36,15 +47,24 @@ signals:
     void positionChanged();
 
 protected:
+    QRect clipRect() const override;
+    void applyDefaultAntialiasingHint(QCPPainter *painter) const override;
     void draw(QCPPainter *painter) override;
     void mouseDoubleClickEvent(QMouseEvent *event, const QVariant &details) override;
 
 private:
+    QPointer<QCPAxis> _keyAxis;
+    QPointer<QCPAxis> _valueAxis;
+    QPen _pen;
+    double _x = 0;
+    double _y = 0;
     bool _followMouse = false;
     bool _canDragX = false, _canDragY = false;
     bool _dragX = false, _dragY = false;
     CursorShape _shape = CrossLines;
 
+    void replotLayer();
+
 private slots:
     void mouseDoubleClick(QMouseEvent*);
     void mouseMove(QMouseEvent*);
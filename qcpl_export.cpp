@@ -1,5 +1,7 @@
 #include "qcpl_export.h"
 
+#include "qcpl_parallel.h"
+
 #include "helpers/OriLayouts.h"
 #include "helpers/OriDialogs.h"
 #include "helpers/OriWidgets.h"
@@ -13,8 +15,10 @@
 #include <QFileDialog>
 #include <QFormLayout>
 #include <QLineEdit>
+#include <QPicture>
 #include <QPushButton>
 #include <QTextStream>
+#include <QThread>
 
 using namespace Ori::Layouts;
 
@@ -431,10 +435,8 @@ bool exportImageDlg(QCustomPlot* plot, ExportToImageProps& props)
     bool saved = true;
     if (!props.scalePixels)
     {
-        QImage image(props.width, props.height, QImage::Format_RGB32);
-        QCPPainter painter(&image);
-        plot->toPainter(&painter, props.width, props.height);
-        saved = image.save(props.fileName);
+        QImage image = renderPlotImage(plot, props.width, props.height);
+        saved = !image.isNull() && image.save(props.fileName);
     }
     else
     {
@@ -458,4 +460,70 @@ bool exportImageDlg(QCustomPlot* plot, ExportToImageProps& props)
     return true;
 }
 
+//------------------------------------------------------------------------------
+//                              renderPlotImage
+//------------------------------------------------------------------------------
+
+/// Images smaller than this (in pixels) are not worth splitting into bands
+const qint64 bandedRenderMinPixels = 4000000;
+
+/// Every band replays all the plot painting commands, so they shouldn't be too thin
+const int minBandHeight = 256;
+
+/// Recording copies played by bands take not more than 1/N of the image memory
+const int maxRecordingsPerImage = 4;
+
+QImage renderPlotImage(QCustomPlot* plot, int width, int height)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    if (image.isNull())
+        return image;
+
+    int bandCount = qMin(QThread::idealThreadCount(), height / minBandHeight);
+    if (qint64(width)*height < bandedRenderMinPixels || bandCount < 2)
+    {
+        QCPPainter painter(&image);
+        plot->toPainter(&painter, width, height);
+        return image;
+    }
+
+    // The plot can only be painted in the GUI thread, so it's recorded once
+    // and then the recording is played into bands of the image in parallel.
+    QPicture picture;
+    {
+        QCPPainter painter(&picture);
+        plot->toPainter(&painter, width, height);
+    }
+
+    // Playing uses an internal buffer of QPicture, so each band needs its own copy of the recording.
+    // It can be large for dense graphs, then there are fewer bands to bound the memory.
+    const qint64 recordingLimit = image.sizeInBytes() / maxRecordingsPerImage;
+    bandCount = int(qMin(qint64(bandCount), recordingLimit / qMax(qint64(picture.size()), qint64(1))));
+    if (bandCount < 2)
+    {
+        QPainter painter(&image);
+        painter.drawPicture(0, 0, picture);
+        return image;
+    }
+
+    // Bands paint right into their rows of the target image, so the image itself is not copied
+    const char *recording = picture.data();
+    const uint recordingSize = picture.size();
+    uchar *bits = image.bits();
+    const qsizetype bytesPerLine = image.bytesPerLine();
+    const int bandHeight = (height + bandCount - 1) / bandCount;
+    runParallel(bandCount, [&](int index){
+        const int top = index * bandHeight;
+        const int h = qMin(bandHeight, height - top);
+        if (h <= 0) return;
+        QImage band(bits + top*bytesPerLine, width, h, bytesPerLine, QImage::Format_RGB32);
+        QPicture bandPicture;
+        bandPicture.setData(recording, recordingSize);
+        QPainter painter(&band);
+        painter.translate(0, -top);
+        painter.drawPicture(0, 0, bandPicture);
+    });
+    return image;
+}
+
 } // namespace QCPL
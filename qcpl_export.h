@@ -2,6 +2,7 @@
 #define QCPL_EXPORT_H
 
 #include <QVector>
+#include <QImage>
 #include <QJsonObject>
 
 QT_BEGIN_NAMESPACE
@@ -82,6 +83,13 @@ struct ExportToImageProps
 
 bool exportImageDlg(QCustomPlot* plot, ExportToImageProps& props);
 
+/// Renders the plot into an image of the given size, the same as QCustomPlot::toPainter() does.
+/// Large images are painted by several threads, each one filling its own horizontal band of the image.
+/// This only speeds the painting up and doesn't lower peak memory: the image is allocated whole because
+/// PNG and JPG encoders of QImageWriter can't take it row by row, and every band plays its own copy
+/// of the plot recording. The copies take not more than 1/4 of the image memory, fewer bands are used otherwise.
+QImage renderPlotImage(QCustomPlot* plot, int width, int height);
+
 } // namespace QCPL
 
 #endif // QCPL_EXPORT_H
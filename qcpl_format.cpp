@@ -113,7 +113,7 @@ bool axisTextDlg(QCPAxis* axis, const AxisFormatDlgProps& props)
             [axis](){ return axis->label(); },
             [axis](const QString& text){ axis->setLabel(text); }))
     {
-        axis->parentPlot()->replot();
+        scheduleReplot(axis->parentPlot());
         return true;
     }
     return false;
@@ -133,7 +133,7 @@ bool titleTextDlg(QCPTextElement* title, const TitleFormatDlgProps& props)
             title->setVisible(true);
         if (auto plot = qobject_cast<Plot*>(title->parentPlot()); plot)
             plot->updateTitleVisibility();
-        title->parentPlot()->replot();
+        scheduleReplot(title->parentPlot());
         return true;
     }
     return false;
@@ -218,7 +218,7 @@ bool plotFormatDlg(Plot* plot, const PlotFormatDlgProps &props)
 
     return Ori::Dlg::Dialog(&editor, false)
             .withTitle(props.title.isEmpty() ? "Plot Format" : props.title)
-            .withOnApply([&editor, plot]{ editor.apply(); plot->replot(); })
+            .withOnApply([&editor, plot]{ editor.apply(); plot->scheduleReplot(); })
             .connectOkToContentApply()
             .exec();
 }
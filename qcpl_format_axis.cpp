@@ -4,6 +4,7 @@
 #include "qcpl_format.h"
 #include "qcpl_format_editors.h"
 #include "qcpl_io_json.h"
+#include "qcpl_plot.h"
 #include "qcpl_text_editor.h"
 #include "qcpl_utils.h"
 #include "qcustomplot/qcustomplot.h"
@@ -483,7 +484,7 @@ void AxisFormatWidget::restore()
     _axis->setLabel(_backup["text"].toString());
     if (_formatter)
         _formatter->setText(_backup["formatter_text"].toString());
-    _axis->parentPlot()->replot();
+    scheduleReplot(_axis->parentPlot());
 }
 
 void AxisFormatWidget::apply()
@@ -571,7 +572,7 @@ void AxisFormatWidget::apply()
     selectedSubTickPen.setWidth(qMax(1, _axis->subTickPen().width()) + 1);
     _axis->setSelectedSubTickPen(selectedSubTickPen);
 
-    _axis->parentPlot()->replot();
+    scheduleReplot(_axis->parentPlot());
 }
 
 bool AxisFormatWidget::needSaveDefault() const
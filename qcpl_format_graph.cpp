@@ -2,6 +2,7 @@
 
 #include "qcpl_format_editors.h"
 #include "qcpl_io_json.h"
+#include "qcpl_plot.h"
 #include "qcustomplot/qcustomplot.h"
 
 #include "helpers/OriLayouts.h"
@@ -124,7 +125,7 @@ void GraphFormatWidget::populate()
 void GraphFormatWidget::restore()
 {
     readGraph(_backup, _graph);
-    _graph->parentPlot()->replot();
+    scheduleReplot(_graph->parentPlot());
 }
 
 void GraphFormatWidget::apply()
@@ -152,7 +153,7 @@ void GraphFormatWidget::apply()
     scatterStyle.setPen(markerPen);
     _graph->setScatterStyle(scatterStyle);
     _graph->setScatterSkip(_markerSkip->value()-1);
-    _graph->parentPlot()->replot();
+    scheduleReplot(_graph->parentPlot());
 }
 
 } // namespace QCPL
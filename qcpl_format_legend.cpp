@@ -3,6 +3,7 @@
 #include "qcpl_format.h"
 #include "qcpl_format_editors.h"
 #include "qcpl_io_json.h"
+#include "qcpl_plot.h"
 #include "qcpl_text_editor.h"
 #include "qcpl_utils.h"
 #include "qcustomplot/qcustomplot.h"
@@ -119,7 +120,7 @@ void LegendFormatWidget::populate()
 void LegendFormatWidget::restore()
 {
     readLegend(_backup, _legend);
-    _legend->parentPlot()->replot();
+    scheduleReplot(_legend->parentPlot());
 }
 
 void LegendFormatWidget::apply()
@@ -135,7 +136,7 @@ void LegendFormatWidget::apply()
     setLegendLocation(_legend, Qt::Alignment(_locationGroup->selectedData().toInt()));
     setLegendMargins(_legend, _margins->value());
     _legend->setVisible(_visible->isChecked());
-    _legend->parentPlot()->replot();
+    scheduleReplot(_legend->parentPlot());
 }
 
 bool LegendFormatWidget::needSaveDefault() const
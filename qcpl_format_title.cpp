@@ -83,7 +83,7 @@ void TitleFormatWidget::restore()
         _formatter->setText(_backup["formatter_text"].toString());
     auto plot = qobject_cast<Plot*>(_title->parentPlot());
     if (plot) plot->updateTitleVisibility();
-    _title->parentPlot()->replot();
+    scheduleReplot(_title->parentPlot());
 }
 
 void TitleFormatWidget::apply()
@@ -114,7 +114,7 @@ void TitleFormatWidget::apply()
 
     if (auto plot = qobject_cast<Plot*>(_title->parentPlot()); plot)
         plot->updateTitleVisibility();
-    _title->parentPlot()->replot();
+    scheduleReplot(_title->parentPlot());
 }
 
 bool TitleFormatWidget::needSaveDefault() const
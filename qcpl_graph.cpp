@@ -1,10 +1,131 @@
 #include "qcpl_graph.h"
 
+#include "qcpl_parallel.h"
+#include "qcpl_raster.h"
+#include "qcpl_simd.h"
+
+#include <QThread>
+
+#include <cmath>
+
 namespace QCPL {
 
-const int maxSelectorHandles = 20;
+/// Graphs larger than this are scanned for value range in parallel chunks of this size at least
+const int parallelRangeChunkSize = 1 << 20;
+
+/// Reduces the range of points [begin, end) to min/max clusters per pixel
+/// using the buckets of the given pyramid level instead of the points themselves.
+/// Edge buckets are taken as a whole, extra points they include take less than a half of pixel.
+template <typename KeyAt>
+static void fillLodLineData(QVector<QCPGraphData> *lineData, const MinMaxPyramid &lod, int level,
+                            int begin, int end, const QCPAxis *keyAxis, KeyAt keyAt)
+{
+    const int bucketSize = 1 << lod.levelShift(level);
+    const int reversedFactor = keyAxis->pixelOrientation();
+    const int reversedRound = reversedFactor==-1 ? 1 : 0;
+    const bool keyEpsilonVariable = keyAxis->scaleType() == QCPAxis::stLogarithmic;
+    double intervalStartKey = 0, keyEpsilon = 0, minValue = 0, maxValue = 0;
+    bool first = true;
+    for (int start = lod.bucketStart(level, begin); start < end; start += bucketSize)
+    {
+        const int index = qMax(start, begin);
+        const double key = keyAt(index);
+        const MinMaxPyramid::Bucket &b = lod.bucket(level, index);
+        if (!first && key < intervalStartKey+keyEpsilon)
+        {
+            if (b.min < minValue || qIsNaN(minValue)) minValue = b.min;
+            if (b.max > maxValue || qIsNaN(maxValue)) maxValue = b.max;
+            continue;
+        }
+        if (!first)
+        {
+            lineData->append(QCPGraphData(intervalStartKey+keyEpsilon*0.25, minValue));
+            lineData->append(QCPGraphData(intervalStartKey+keyEpsilon*0.75, maxValue));
+        }
+        minValue = b.min;
+        maxValue = b.max;
+        intervalStartKey = keyAxis->pixelToCoord(int(keyAxis->coordToPixel(key)+reversedRound));
+        if (first || keyEpsilonVariable)
+            keyEpsilon = qAbs(intervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(intervalStartKey)+1.0*reversedFactor));
+        first = false;
+    }
+    if (!first)
+    {
+        lineData->append(QCPGraphData(intervalStartKey+keyEpsilon*0.25, minValue));
+        lineData->append(QCPGraphData(intervalStartKey+keyEpsilon*0.75, maxValue));
+    }
+}
+
+//------------------------------------------------------------------------------
+//                               makeGraphData
+//------------------------------------------------------------------------------
+
+static QSharedPointer<QCPGraphDataContainer> adoptPoints(QVector<QCPGraphData> &points, bool sorted)
+{
+    // Sort while the vector is not shared yet, otherwise sorting in the container would detach it
+    if (!sorted && !std::is_sorted(points.constBegin(), points.constEnd(), qcpLessThanSortKey<QCPGraphData>))
+        std::sort(points.begin(), points.end(), qcpLessThanSortKey<QCPGraphData>);
+
+    // The container only shares the implicitly shared vector, points are not copied here
+    QSharedPointer<QCPGraphDataContainer> container(new QCPGraphDataContainer);
+    container->set(points, true);
+    return container;
+}
+
+QSharedPointer<QCPGraphDataContainer> makeGraphData(const double *keys, const double *values, int count, bool sorted)
+{
+    QVector<QCPGraphData> points(count);
+    QCPGraphData *p = points.data();
+    for (int i = 0; i < count; i++)
+    {
+        p[i].key = keys[i];
+        p[i].value = values[i];
+    }
+    return adoptPoints(points, sorted);
+}
+
+QSharedPointer<QCPGraphDataContainer> makeGraphData(GraphData &&data, bool sorted)
+{
+    if (data.x.size() != data.y.size())
+        qWarning() << Q_FUNC_INFO << "keys and values have different sizes:" << data.x.size() << data.y.size();
+    QVector<QCPGraphData> points(qMin(data.x.size(), data.y.size()));
+    {
+        const double *keys = data.x.constData();
+        const double *values = data.y.constData();
+        QCPGraphData *p = points.data();
+        for (int i = 0; i < points.size(); i++)
+        {
+            p[i].key = keys[i];
+            p[i].value = values[i];
+        }
+    }
+    // The source is not needed anymore, release it before sorting
+    data.x = ValueArray();
+    data.y = ValueArray();
+    return adoptPoints(points, sorted);
+}
+
+/// Accounts a new point in the cached bounds, non-finite values are skipped
+/// the same way as QCPDataContainer::valueRange() and findMinMax() do.
+static void expandBounds(QCPRange &range, bool &found, double value, QCP::SignDomain signDomain)
+{
+    if (!std::isfinite(value)) return;
+    if (signDomain == QCP::sdPositive && value <= 0) return;
+    if (signDomain == QCP::sdNegative && value >= 0) return;
+    if (!found)
+    {
+        range = QCPRange(value, value);
+        found = true;
+    }
+    else range.expand(value);
+}
+
+//------------------------------------------------------------------------------
+//                                 LineGraph
+//------------------------------------------------------------------------------
 
 QCPSelectionDecorator* LineGraph::_sharedSelectionDecorator = nullptr;
+LineGraph::SelectorHandles LineGraph::_selectorHandles;
 
 void LineGraph::setSharedSelectionDecorator(QCPSelectionDecorator* decorator)
 {
@@ -16,92 +137,959 @@ void LineGraph::setSharedSelectionDecorator(QCPSelectionDecorator* decorator)
     _sharedSelectionDecorator = decorator;
 }
 
+void LineGraph::setSelectorHandles(const SelectorHandles &handles)
+{
+    _selectorHandles = handles;
+}
+
 LineGraph::LineGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) : QCPGraph(keyAxis, valueAxis)
 {
 }
 
-void LineGraph::draw(QCPPainter *painter)
+void LineGraph::setMaxPointCount(int count)
 {
-  if (!mKeyAxis || !mValueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
-  if (mKeyAxis.data()->range().size() <= 0 || mDataContainer->isEmpty()) return;
-  if (mLineStyle == lsNone && mScatterStyle.isNone()) return;
+    _maxPointCount = qMax(0, count);
+    if (_maxPointCount == 0)
+        restoreAutoSqueeze();
+    dropOldPoints();
+}
 
-  QVector<QPointF> lines, scatters; // line and (if necessary) scatter pixel coordinates will be stored here while iterating over segments
+void LineGraph::appendData(const ValueArray &keys, const ValueArray &values)
+{
+    if (keys.size() != values.size())
+        qWarning() << Q_FUNC_INFO << "keys and values have different sizes:" << keys.size() << values.size();
+    appendData(keys.constData(), values.constData(), qMin(keys.size(), values.size()));
+}
 
-  QCPSelectionDecorator* selectionDecorator = _sharedSelectionDecorator ? _sharedSelectionDecorator : mSelectionDecorator;
+void LineGraph::appendData(const double *keys, const double *values, int count)
+{
+    if (count <= 0) return;
 
-  // loop over and draw segments of unselected/selected data:
-  QList<QCPDataRange> selectedSegments, unselectedSegments, allSegments;
-  getDataSegments(selectedSegments, unselectedSegments);
-  allSegments << unselectedSegments << selectedSegments;
-  for (int i=0; i<allSegments.size(); ++i)
-  {
-    bool isSelectedSegment = i >= unselectedSegments.size();
-    // get line pixel points appropriate to line style:
-    QCPDataRange lineDataRange = isSelectedSegment ? allSegments.at(i) : allSegments.at(i).adjusted(-1, 1); // unselected segments extend lines to bordering selected data point (safe to exceed total data bounds in first/last segment, getLines takes care)
-    getLines(&lines, lineDataRange);
+    if (_dataSource)
+    {
+        qWarning() << Q_FUNC_INFO << "can't append to external data source";
+        return;
+    }
+
+    // The fast path is only valid for a tail append: keys must be ascending
+    // and continue the existing ones. Otherwise the points are merged the usual way.
+    bool tail = mDataContainer->isEmpty() || !(keys[0] < (mDataContainer->constEnd()-1)->key);
+    for (int i = 1; i < count && tail; i++)
+        tail = !(keys[i] < keys[i-1]);
+    if (!tail)
+    {
+        QVector<QCPGraphData> points(count);
+        for (int i = 0; i < count; i++)
+            points[i] = QCPGraphData(keys[i], values[i]);
+        mDataContainer->add(points, false);
+        invalidateDataCache();
+        dropOldPoints();
+        return;
+    }
+
+    // Points that would be dropped immediately are not even added
+    if (_maxPointCount > 0 && count > _maxPointCount)
+    {
+        keys += count - _maxPointCount;
+        values += count - _maxPointCount;
+        count = _maxPointCount;
+    }
+
+    QVector<QCPGraphData> points(count);
+    QCPGraphData *p = points.data();
+    for (int i = 0; i < count; i++)
+    {
+        p[i].key = keys[i];
+        p[i].value = values[i];
+    }
+    // Caches are only updated if they are in sync with the data, otherwise they are rebuilt on demand
+    const bool lodInSync = _lodEnabled && _lodData == dataId() && _lod.size() == mDataContainer->size();
+    const bool boundsInSync = _boundsData == dataId() && _boundsSize == mDataContainer->size();
+
+    // Keys are ascending and continue the existing ones, see the check above
+    mDataContainer->add(points, true);
+    _dataVersion++;
+
+    if (lodInSync)
+    {
+        for (int i = 0; i < count; i++)
+            _lod.append(values[i]);
+    }
+    else
+        _lodData = nullptr;
+
+    if (boundsInSync)
+    {
+        for (int sd = 0; sd < 3; sd++)
+            for (int i = 0; i < count; i++)
+            {
+                if (_keyBounds[sd].valid)
+                    expandBounds(_keyBounds[sd].range, _keyBounds[sd].found, keys[i], QCP::SignDomain(sd));
+                if (_valueBounds[sd].valid)
+                    expandBounds(_valueBounds[sd].range, _valueBounds[sd].found, values[i], QCP::SignDomain(sd));
+            }
+        _boundsSize = mDataContainer->size();
+    }
+
+    dropOldPoints();
+}
+
+void LineGraph::dropOldPoints()
+{
+    if (_maxPointCount <= 0) return;
+
+    int extraCount = mDataContainer->size() - _maxPointCount;
+    if (extraCount <= 0) return;
+
+    // The container must stay contiguous for QCPGraph, so it's a sliding window rather than a true ring.
+    // Dropped points only become the container's preallocated space, which is O(1).
+    // Auto-squeeze would reallocate the buffer back and forth, so we compact it by ourselves
+    // once the dropped points take as much room as the kept ones, this is amortized O(1) per point.
+    if (!_squeezeDisabled)
+    {
+        _savedAutoSqueeze = mDataContainer->autoSqueeze();
+        _squeezeDisabled = true;
+        mDataContainer->setAutoSqueeze(false);
+    }
+    const double firstKeptKey = mDataContainer->at(extraCount)->key;
+    const bool boundsInSync = _boundsData == dataId() && _boundsSize == mDataContainer->size();
+    if (boundsInSync)
+    {
+        // Value bounds only have to be recalculated when a dropped point was on the edge
+        auto it = mDataContainer->constBegin();
+        for (int i = 0; i < extraCount; i++, ++it)
+            for (auto &cache : _valueBounds)
+                if (cache.valid && cache.found && (it->value <= cache.range.lower || it->value >= cache.range.upper))
+                    cache.valid = false;
+    }
+    // Removed by index, removing by key would keep points having the same key as the first kept one
+    mDataContainer->removeFirst(extraCount);
+    _dataVersion++;
+    if (_lodData == dataId())
+    {
+        _lod.dropFront(extraCount);
+        auto data = mDataContainer->constBegin();
+        _lod.refreshFront([data](int i){ return (data+i)->value; });
+    }
+    if (boundsInSync)
+    {
+        // Keys are sorted, so key bounds are just moved to the new first key
+        auto &both = _keyBounds[QCP::sdBoth];
+        if (both.valid && both.found) both.range.lower = firstKeptKey;
+        auto &positive = _keyBounds[QCP::sdPositive];
+        if (positive.valid && positive.found && firstKeptKey > 0) positive.range.lower = firstKeptKey;
+        auto &negative = _keyBounds[QCP::sdNegative];
+        if (negative.valid && negative.found)
+        {
+            if (firstKeptKey < 0)
+                negative.range.lower = firstKeptKey;
+            else
+                negative = CachedRange{ QCPRange(), false, true };
+        }
+        _boundsSize = mDataContainer->size();
+    }
+    _droppedPointCount += extraCount;
+    if (_droppedPointCount >= _maxPointCount)
+    {
+        mDataContainer->squeeze(true, false);
+        _droppedPointCount = 0;
+    }
+}
 
-    // draw selection:
-    if (isSelectedSegment && selectionDecorator && selectionDecorator->pen() != Qt::NoPen)
+void LineGraph::restoreAutoSqueeze()
+{
+    if (!_squeezeDisabled) return;
+    mDataContainer->setAutoSqueeze(_savedAutoSqueeze);
+    _squeezeDisabled = false;
+    _droppedPointCount = 0;
+}
+
+void LineGraph::setData(QSharedPointer<QCPGraphDataContainer> data)
+{
+    restoreAutoSqueeze();
+    QCPGraph::setData(data);
+    invalidateDataCache();
+}
+
+void LineGraph::setData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted)
+{
+    restoreAutoSqueeze();
+    QCPGraph::setData(keys, values, alreadySorted);
+    invalidateDataCache();
+}
+
+void LineGraph::addData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted)
+{
+    QCPGraph::addData(keys, values, alreadySorted);
+    invalidateDataCache();
+}
+
+void LineGraph::addData(double key, double value)
+{
+    QCPGraph::addData(key, value);
+    invalidateDataCache();
+}
+
+void LineGraph::setDataSource(const QSharedPointer<GraphDataSource> &source)
+{
+    _dataSource = source;
+    if (_dataSource)
+        mDataContainer->clear();
+    invalidateDataCache();
+}
+
+void LineGraph::setLodEnabled(bool on)
+{
+    _lodEnabled = on;
+    _lod.clear();
+    _lodData = nullptr;
+}
+
+void LineGraph::invalidateDataCache()
+{
+    _lodData = nullptr;
+    _boundsData = nullptr;
+    _dataVersion++;
+}
+
+void LineGraph::syncBounds() const
+{
+    if (_boundsData == dataId() && _boundsSize == dataCount())
+        return;
+    for (int i = 0; i < 3; i++)
+        _keyBounds[i].valid = _valueBounds[i].valid = false;
+    _boundsData = dataId();
+    _boundsSize = dataCount();
+}
+
+const void* LineGraph::dataId() const
+{
+    if (_dataSource)
+        return _dataSource.data();
+    return mDataContainer.data();
+}
+
+void LineGraph::ensureLod() const
+{
+    if (_lodData == dataId() && _lod.size() == dataCount())
+        return;
+
+    if (_dataSource)
     {
-      QPen selectionPen(selectionDecorator->pen());
-      if (mLineStyle != lsNone)
-      {
-        selectionPen.setWidth(mPen.width() + 2*selectionDecorator->pen().width());
-        selectionPen.setCapStyle(Qt::RoundCap);
-      }
+        auto source = _dataSource.data();
+        _lod.build(source->size(), [source](int i){ return source->value(i); });
+    }
+    else
+    {
+        auto data = mDataContainer->constBegin();
+        _lod.build(mDataContainer->size(), [data](int i){ return (data+i)->value; });
+    }
+    _lodData = dataId();
+}
+
+bool LineGraph::getDraftLineData(QVector<QCPGraphData> *lineData, int begin, int end) const
+{
+    if (_draftPoints <= 1 || end - begin <= _draftPoints)
+        return false;
 
-      painter->setPen(selectionPen);
-      painter->setBrush(Qt::NoBrush);
+    // Points are just taken with even stride, the exact geometry is calculated on a later pass anyway
+    const qint64 lastOffset = end - begin - 1;
+    lineData->resize(_draftPoints);
+    for (int i = 0; i < _draftPoints; i++)
+    {
+        const int index = begin + int(lastOffset*i/(_draftPoints-1));
+        (*lineData)[i] = QCPGraphData(dataMainKey(index), dataMainValue(index));
+    }
+    return true;
+}
+
+bool LineGraph::getLodLineData(QVector<QCPGraphData> *lineData, int begin, int end) const
+{
+    if (!_lodEnabled || !mAdaptiveSampling || end - begin < 2)
+        return false;
+
+    ensureLod();
+
+    QCPAxis *keyAxis = mKeyAxis.data();
+    const double keyPixelSpan = qAbs(keyAxis->coordToPixel(dataMainKey(begin)) - keyAxis->coordToPixel(dataMainKey(end-1)));
+    const int level = _lod.levelFor((end - begin) / (2*keyPixelSpan + 2));
+    if (level < 0)
+        return false;
+
+    lineData->clear();
+    if (_dataSource)
+    {
+        auto source = _dataSource.data();
+        fillLodLineData(lineData, _lod, level, begin, end, keyAxis, [source](int i){ return source->key(i); });
+    }
+    else
+    {
+        auto data = mDataContainer->constBegin();
+        fillLodLineData(lineData, _lod, level, begin, end, keyAxis, [data](int i){ return (data+i)->key; });
+    }
+    return true;
+}
+
+void LineGraph::getOptimizedLineData(QVector<QCPGraphData> *lineData, const QCPGraphDataContainer::const_iterator &begin, const QCPGraphDataContainer::const_iterator &end) const
+{
+    if (!lineData) return;
+    auto data = mDataContainer->constBegin();
+    if (!getDraftLineData(lineData, int(begin - data), int(end - data)) &&
+        !getLodLineData(lineData, int(begin - data), int(end - data)))
+        QCPGraph::getOptimizedLineData(lineData, begin, end);
+}
+
+int LineGraph::dataCount() const
+{
+    return _dataSource ? _dataSource->size() : QCPGraph::dataCount();
+}
+
+double LineGraph::dataMainKey(int index) const
+{
+    return _dataSource ? _dataSource->key(index) : QCPGraph::dataMainKey(index);
+}
+
+double LineGraph::dataSortKey(int index) const
+{
+    return _dataSource ? _dataSource->key(index) : QCPGraph::dataSortKey(index);
+}
+
+double LineGraph::dataMainValue(int index) const
+{
+    return _dataSource ? _dataSource->value(index) : QCPGraph::dataMainValue(index);
+}
+
+QCPRange LineGraph::dataValueRange(int index) const
+{
+    if (!_dataSource)
+        return QCPGraph::dataValueRange(index);
+    const double value = _dataSource->value(index);
+    return QCPRange(value, value);
+}
+
+QPointF LineGraph::dataPixelPosition(int index) const
+{
+    if (!_dataSource)
+        return QCPGraph::dataPixelPosition(index);
+    return coordsToPixels(_dataSource->key(index), _dataSource->value(index));
+}
+
+int LineGraph::findBegin(double sortKey, bool expandedRange) const
+{
+    return _dataSource ? _dataSource->findBegin(sortKey, expandedRange) : QCPGraph::findBegin(sortKey, expandedRange);
+}
+
+int LineGraph::findEnd(double sortKey, bool expandedRange) const
+{
+    return _dataSource ? _dataSource->findEnd(sortKey, expandedRange) : QCPGraph::findEnd(sortKey, expandedRange);
+}
+
+QCPRange LineGraph::getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain) const
+{
+    syncBounds();
+    CachedRange &cache = _keyBounds[inSignDomain];
+    if (!cache.valid)
+    {
+        cache.range = _dataSource
+            ? _dataSource->keyRange(cache.found, inSignDomain)
+            : QCPGraph::getKeyRange(cache.found, inSignDomain);
+        cache.valid = true;
+    }
+    foundRange = cache.found;
+    return cache.range;
+}
+
+QCPRange LineGraph::getValueRange(bool &foundRange, QCP::SignDomain inSignDomain, const QCPRange &inKeyRange) const
+{
+    // Only bounds of the whole data are cached
+    if (inKeyRange != QCPRange())
+        return calcValueRange(foundRange, inSignDomain, findBegin(inKeyRange.lower, false), findEnd(inKeyRange.upper, false));
 
-      drawLinePlot(painter, lines);
+    syncBounds();
+    CachedRange &cache = _valueBounds[inSignDomain];
+    if (!cache.valid)
+    {
+        cache.range = calcValueRange(cache.found, inSignDomain, 0, dataCount());
+        cache.valid = true;
     }
+    foundRange = cache.found;
+    return cache.range;
+}
+
+double LineGraph::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const
+{
+    if (!_dataSource)
+        return QCPGraph::selectTest(pos, onlySelectable, details);
+
+    if ((onlySelectable && mSelectable == QCP::stNone) || _dataSource->isEmpty())
+        return -1;
+    if (!mKeyAxis || !mValueAxis)
+        return -1;
+    if (mLineStyle == lsNone && mScatterStyle.isNone())
+        return -1;
+    if (!mKeyAxis->axisRect()->rect().contains(pos.toPoint()) && !mParentPlot->interactions().testFlag(QCP::iSelectPlottablesBeyondAxisRect))
+        return -1;
 
-    // draw line:
+    // The same as QCPGraph::pointDistance() does but on the source points
+    double posKeyMin, posKeyMax, dummy;
+    const double tolerance = mParentPlot->selectionTolerance();
+    pixelsToCoords(pos - QPointF(tolerance, tolerance), posKeyMin, dummy);
+    pixelsToCoords(pos + QPointF(tolerance, tolerance), posKeyMax, dummy);
+    if (posKeyMin > posKeyMax)
+        qSwap(posKeyMin, posKeyMax);
+    double minDistSqr = (std::numeric_limits<double>::max)();
+    int closestIndex = -1;
+    const int end = _dataSource->findEnd(posKeyMax, true);
+    for (int i = _dataSource->findBegin(posKeyMin, true); i < end; i++)
+    {
+        const double distSqr = QCPVector2D(coordsToPixels(_dataSource->key(i), _dataSource->value(i)) - pos).lengthSquared();
+        if (distSqr < minDistSqr)
+        {
+            minDistSqr = distSqr;
+            closestIndex = i;
+        }
+    }
     if (mLineStyle != lsNone)
     {
-      painter->setPen(mPen);
-      painter->setBrush(Qt::NoBrush);
+        QVector<QPointF> lines;
+        getSourceLines(&lines, QCPDataRange(0, _dataSource->size()));
+        QCPVector2D p(pos);
+        const int step = mLineStyle == lsImpulse ? 2 : 1;
+        for (int i = 0; i < lines.size()-1; i += step)
+        {
+            const double distSqr = p.distanceSquaredToLine(lines.at(i), lines.at(i+1));
+            if (distSqr < minDistSqr)
+                minDistSqr = distSqr;
+        }
+    }
+    if (details && closestIndex >= 0)
+        details->setValue(QCPDataSelection(QCPDataRange(closestIndex, closestIndex+1)));
+    return qSqrt(minDistSqr);
+}
+
+QCPDataSelection LineGraph::selectTestRect(const QRectF &rect, bool onlySelectable) const
+{
+    if (!_dataSource)
+        return QCPGraph::selectTestRect(rect, onlySelectable);
+
+    QCPDataSelection result;
+    if ((onlySelectable && mSelectable == QCP::stNone) || _dataSource->isEmpty())
+        return result;
+    if (!mKeyAxis || !mValueAxis)
+        return result;
+
+    double key1, value1, key2, value2;
+    pixelsToCoords(rect.topLeft(), key1, value1);
+    pixelsToCoords(rect.bottomRight(), key2, value2);
+    QCPRange keyRange(key1, key2);
+    QCPRange valueRange(value1, value2);
+    const int begin = _dataSource->findBegin(keyRange.lower, false);
+    const int end = _dataSource->findEnd(keyRange.upper, false);
+    int segmentBegin = -1;
+    for (int i = begin; i < end; i++)
+    {
+        const bool inside = valueRange.contains(_dataSource->value(i)) && keyRange.contains(_dataSource->key(i));
+        if (segmentBegin == -1 && inside)
+            segmentBegin = i;
+        else if (segmentBegin != -1 && !inside)
+        {
+            result.addDataRange(QCPDataRange(segmentBegin, i), false);
+            segmentBegin = -1;
+        }
+    }
+    if (segmentBegin != -1)
+        result.addDataRange(QCPDataRange(segmentBegin, end), false);
+    result.simplify();
+    return result;
+}
+
+QCPRange LineGraph::calcValueRange(bool &foundRange, QCP::SignDomain signDomain, int begin, int end) const
+{
+    auto calcChunk = [this, signDomain](CachedRange &r, int begin, int end) {
+        if (_dataSource)
+            r.range = _dataSource->valueRange(r.found, signDomain, begin, end);
+        else
+            r.found = findMinMax(&*(mDataContainer->constBegin() + begin), end - begin, signDomain, r.range.lower, r.range.upper);
+    };
+
+    const int count = end - begin;
+    const int chunkCount = qMin(count / parallelRangeChunkSize, QThread::idealThreadCount());
+    if (chunkCount <= 1)
+    {
+        CachedRange r;
+        if (count > 0)
+            calcChunk(r, begin, end);
+        foundRange = r.found;
+        return r.found ? r.range : QCPRange();
+    }
+
+    QVector<CachedRange> chunks(chunkCount);
+    runParallel(chunkCount, [&](int chunk){
+        calcChunk(chunks[chunk], begin + qint64(count) * chunk / chunkCount, begin + qint64(count) * (chunk+1) / chunkCount);
+    });
+
+    foundRange = false;
+    QCPRange range;
+    for (const auto &r : std::as_const(chunks))
+        if (r.found)
+        {
+            if (!foundRange)
+            {
+                range = r.range;
+                foundRange = true;
+            }
+            else range.expand(r.range);
+        }
+    return range;
+}
+
+void LineGraph::getSourceBounds(int &begin, int &end, const QCPDataRange &rangeRestriction) const
+{
+    begin = end = 0;
+    if (rangeRestriction.isEmpty()) return;
+    const QCPRange &range = mKeyAxis->range();
+    begin = qMax(_dataSource->findBegin(range.lower), rangeRestriction.begin());
+    end = qMin(_dataSource->findEnd(range.upper), rangeRestriction.end());
+    end = qMax(begin, end);
+}
+
+void LineGraph::getIndexBounds(int &begin, int &end, const QCPDataRange &dataRange) const
+{
+    if (_dataSource)
+        getSourceBounds(begin, end, dataRange);
+    else
+    {
+        QCPGraphDataContainer::const_iterator itBegin, itEnd;
+        getVisibleDataBounds(itBegin, itEnd, dataRange);
+        begin = int(itBegin - mDataContainer->constBegin());
+        end = int(itEnd - mDataContainer->constBegin());
+    }
+}
+
+void LineGraph::getSourceLines(QVector<QPointF> *lines, const QCPDataRange &dataRange) const
+{
+    if (!lines) return;
+    lines->clear();
+    if (mLineStyle == lsNone) return;
+
+    int begin, end;
+    getSourceBounds(begin, end, dataRange);
+    if (begin == end) return;
 
-      drawLinePlot(painter, lines); // also step plots can be drawn as a line plot
+    QVector<QCPGraphData> lineData;
+    if (!getDraftLineData(&lineData, begin, end) && !getLodLineData(&lineData, begin, end))
+        _dataSource->getLineData(&lineData, begin, end, mKeyAxis.data(), mAdaptiveSampling);
+
+    if (mKeyAxis->rangeReversed() != (mKeyAxis->orientation() == Qt::Vertical))
+        std::reverse(lineData.begin(), lineData.end());
+
+    switch (mLineStyle)
+    {
+    case lsNone: break;
+    case lsLine: *lines = dataToLines(lineData); break;
+    case lsStepLeft: *lines = dataToStepLeftLines(lineData); break;
+    case lsStepRight: *lines = dataToStepRightLines(lineData); break;
+    case lsStepCenter: *lines = dataToStepCenterLines(lineData); break;
+    case lsImpulse: *lines = dataToImpulseLines(lineData); break;
+    }
+}
+
+void LineGraph::getSourceScatters(QVector<QPointF> *scatters, const QCPDataRange &dataRange) const
+{
+    if (!scatters) return;
+    scatters->clear();
+
+    int begin, end;
+    getSourceBounds(begin, end, dataRange);
+    if (begin == end) return;
+
+    // Scatters can't be merged into pixel clusters like lines,
+    // so with adaptive sampling they are just thinned out to about two per pixel
+    int step = mScatterSkip + 1;
+    if (mAdaptiveSampling)
+    {
+        const QCPAxis *keyAxis = mKeyAxis.data();
+        const double keyPixelSpan = qAbs(keyAxis->coordToPixel(_dataSource->key(begin)) - keyAxis->coordToPixel(_dataSource->key(end-1)));
+        const int maxCount = int(qMin(2*keyPixelSpan+2, double(std::numeric_limits<int>::max())));
+        if (end - begin > maxCount)
+            step = qMax(step, (end - begin) / maxCount);
+    }
+    begin = (begin + step - 1) / step * step;
+
+    const bool reversed = mKeyAxis->rangeReversed() != (mKeyAxis->orientation() == Qt::Vertical);
+    scatters->reserve((end - begin) / step + 1);
+    for (int i = begin; i < end; i += step)
+    {
+        const double value = _dataSource->value(i);
+        if (!qIsNaN(value))
+            scatters->append(coordsToPixels(_dataSource->key(i), value));
+    }
+    if (reversed)
+        std::reverse(scatters->begin(), scatters->end());
+}
+
+void LineGraph::getGraphLines(QVector<QPointF> *lines, const QCPDataRange &dataRange) const
+{
+    if (_dataSource)
+        getSourceLines(lines, dataRange);
+    else
+        getLines(lines, dataRange);
+}
+
+void LineGraph::getGraphScatters(QVector<QPointF> *scatters, const QCPDataRange &dataRange) const
+{
+    if (_draftPoints > 1)
+    {
+        int begin, end;
+        getIndexBounds(begin, end, dataRange);
+        if (end - begin > _draftPoints)
+        {
+            scatters->clear();
+            scatters->reserve(_draftPoints);
+            const qint64 lastOffset = end - begin - 1;
+            for (int i = 0; i < _draftPoints; i++)
+            {
+                const int index = begin + int(lastOffset*i/(_draftPoints-1));
+                const double value = dataMainValue(index);
+                if (!qIsNaN(value))
+                    scatters->append(coordsToPixels(dataMainKey(index), value));
+            }
+            return;
+        }
+    }
+    if (_dataSource)
+        getSourceScatters(scatters, dataRange);
+    else
+        getScatters(scatters, dataRange);
+}
+
+void LineGraph::getSelectorHandles(QVector<QPointF> *handles, const QCPDataRange &dataRange) const
+{
+    handles->clear();
+    const int maxCount = _selectorHandles.maxCount;
+    if (maxCount <= 0) return;
+
+    int begin, end;
+    getIndexBounds(begin, end, dataRange);
+    if (begin >= end) return;
+
+    // Only the handles' own points are converted to pixels, not the whole segment
+    const int count = end - begin;
+    const int handleCount = qMin(maxCount, count);
+    const bool byKey = _selectorHandles.distribution == SelectorHandles::ByKey;
+    const double firstKey = dataMainKey(begin);
+    const double lastKey = dataMainKey(end-1);
+    handles->reserve(handleCount);
+    int prevIndex = -1;
+    for (int h = 0; h < handleCount; h++)
+    {
+        int index = begin;
+        if (handleCount > 1)
+        {
+            if (byKey)
+                index = qBound(begin, findBegin(firstKey + (lastKey - firstKey)*h/(handleCount-1), false), end-1);
+            else
+                index = begin + int(qint64(count-1)*h/(handleCount-1));
+        }
+        // Points can be sparse in key, then several handles fall onto the same point
+        if (index == prevIndex) continue;
+        prevIndex = index;
+        const double value = dataMainValue(index);
+        if (!qIsNaN(value))
+            handles->append(coordsToPixels(dataMainKey(index), value));
+    }
+}
+
+bool LineGraph::GeometryKey::operator ==(const GeometryKey &other) const
+{
+    return keyAxis == other.keyAxis && valueAxis == other.valueAxis &&
+        keyOrientation == other.keyOrientation && valueOrientation == other.valueOrientation &&
+        keyRange == other.keyRange && valueRange == other.valueRange &&
+        keyAxisRect == other.keyAxisRect && valueAxisRect == other.valueAxisRect &&
+        keyReversed == other.keyReversed && valueReversed == other.valueReversed &&
+        keyScale == other.keyScale && valueScale == other.valueScale &&
+        lineStyle == other.lineStyle && adaptiveSampling == other.adaptiveSampling &&
+        lodEnabled == other.lodEnabled && scatterSkip == other.scatterSkip && draftPoints == other.draftPoints &&
+        data == other.data && dataCount == other.dataCount && dataVersion == other.dataVersion;
+}
+
+LineGraph::GeometryKey LineGraph::geometryKey() const
+{
+    GeometryKey key;
+    QCPAxis *keyAxis = mKeyAxis.data();
+    QCPAxis *valueAxis = mValueAxis.data();
+    key.keyAxis = keyAxis;
+    key.valueAxis = valueAxis;
+    key.keyOrientation = keyAxis->orientation();
+    key.valueOrientation = valueAxis->orientation();
+    key.keyRange = keyAxis->range();
+    key.valueRange = valueAxis->range();
+    key.keyAxisRect = keyAxis->axisRect()->rect();
+    key.valueAxisRect = valueAxis->axisRect()->rect();
+    key.keyReversed = keyAxis->rangeReversed();
+    key.valueReversed = valueAxis->rangeReversed();
+    key.keyScale = keyAxis->scaleType();
+    key.valueScale = valueAxis->scaleType();
+    key.lineStyle = mLineStyle;
+    key.adaptiveSampling = mAdaptiveSampling;
+    key.lodEnabled = _lodEnabled;
+    key.scatterSkip = mScatterSkip;
+    key.draftPoints = _draftPoints;
+    key.data = dataId();
+    key.dataCount = dataCount();
+    key.dataVersion = _dataVersion;
+    return key;
+}
+
+void LineGraph::prepareGeometry()
+{
+    if (!mKeyAxis || !mValueAxis || mKeyAxis.data()->range().size() <= 0 || dataCount() == 0 ||
+        (mLineStyle == lsNone && mScatterStyle.isNone()))
+    {
+        _geometry.clear();
+        return;
     }
 
-    // draw scatters:
-    if (!mScatterStyle.isNone())
+    const GeometryKey key = geometryKey();
+    if (!(key == _geometryKey))
     {
-      getScatters(&scatters, allSegments.at(i));
-      drawScatterPlot(painter, scatters, mScatterStyle);
+        _geometry.clear();
+        _geometryKey = key;
     }
 
-    // draw selection:
-    if (isSelectedSegment && selectionDecorator && !selectionDecorator->scatterStyle().isNone())
+    QCPSelectionDecorator* selectionDecorator = activeSelectionDecorator();
+    const bool selectorHandles = selectionDecorator && !selectionDecorator->scatterStyle().isNone();
+    const QCPDataRange dataBounds(0, dataCount());
+
+    QList<QCPDataRange> selectedSegments, unselectedSegments, allSegments;
+    getDataSegments(selectedSegments, unselectedSegments);
+    allSegments << unselectedSegments << selectedSegments;
+
+    // Segments are only split differently when selection changes, their geometry stays the same.
+    // E.g. when the whole graph gets selected, its only segment is taken as is.
+    QVector<SegmentGeometry> cached;
+    cached.swap(_geometry);
+    _geometry.resize(allSegments.size());
+    for (int i = 0; i < allSegments.size(); i++)
     {
-      if (scatters.isEmpty())
-        getScatters(&scatters, allSegments.at(i));
+        SegmentGeometry &segment = _geometry[i];
+        segment.selected = i >= unselectedSegments.size();
+        segment.scatterRange = allSegments.at(i);
+        // Unselected segments extend lines to bordering selected data point
+        segment.lineRange = (segment.selected ? segment.scatterRange : segment.scatterRange.adjusted(-1, 1)).bounded(dataBounds);
 
-      if (scatters.size() <= maxSelectorHandles)
-      {
-        drawScatterPlot(painter, scatters, selectionDecorator->scatterStyle());
-      }
-      else
-      {
-        QVector<QPointF> selectorHandles;
-        selectorHandles.resize(maxSelectorHandles);
-        int step = scatters.size() / maxSelectorHandles;
-        for (int si = 0, hi = 0; si < scatters.size() && hi < maxSelectorHandles; si += step, hi++)
+        for (SegmentGeometry &old : cached)
         {
-          const QPointF& p = scatters.at(si);
-          selectorHandles[hi].setX(p.x());
-          selectorHandles[hi].setY(p.y());
+            if (!segment.hasLines && old.hasLines && old.lineRange == segment.lineRange)
+            {
+                segment.lines.swap(old.lines);
+                segment.hasLines = true;
+                old.hasLines = false;
+            }
+            if (!segment.hasScatters && old.hasScatters && old.scatterRange == segment.scatterRange)
+            {
+                segment.scatters.swap(old.scatters);
+                segment.hasScatters = true;
+                old.hasScatters = false;
+            }
         }
-        drawScatterPlot(painter, selectorHandles, selectionDecorator->scatterStyle());
-      }
+        if (!segment.hasLines)
+        {
+            getGraphLines(&segment.lines, segment.lineRange);
+            segment.hasLines = true;
+        }
+        if (!segment.hasScatters && !mScatterStyle.isNone() && !_linesOnly)
+        {
+            getGraphScatters(&segment.scatters, segment.scatterRange);
+            segment.hasScatters = true;
+        }
+        // Handles are few, they are recalculated each time to follow the handles settings
+        if (segment.selected && selectorHandles)
+            getSelectorHandles(&segment.handles, segment.scatterRange);
     }
+}
+
+void LineGraph::setDraftPoints(int count)
+{
+    _draftPoints = qMax(0, count);
+}
+
+int LineGraph::visiblePointCount() const
+{
+    if (!mKeyAxis) return 0;
+    const QCPRange range = mKeyAxis->range();
+    return qMax(0, findEnd(range.upper, false) - findBegin(range.lower, false));
+}
+
+bool LineGraph::hasExactGeometry() const
+{
+    if (_geometry.isEmpty() || !mKeyAxis || !mValueAxis) return false;
+    GeometryKey key = geometryKey();
+    key.draftPoints = 0;
+    return key == _geometryKey;
+}
+
+void LineGraph::setLinesOnly(bool on)
+{
+    _linesOnly = on;
+}
+
+void LineGraph::setSelectionOnOverlay(bool on)
+{
+    _selectionOnOverlay = on;
+}
+
+void LineGraph::setFastLineRaster(bool on)
+{
+    _fastLineRaster = on;
+}
+
+void LineGraph::setScatterStamps(bool on)
+{
+    _scatterStamps = on;
+}
+
+void LineGraph::draw(QCPPainter *painter)
+{
+  if (!mKeyAxis || !mValueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
+
+  // Exports are always exact, progressive drafts are only for the screen
+  if (_draftPoints > 0 && painter->modes().testFlag(QCPPainter::pmNoCaching))
+  {
+    const int draftPoints = _draftPoints;
+    _draftPoints = 0;
+    draw(painter);
+    _draftPoints = draftPoints;
+    return;
   }
 
+  // Geometry is usually prepared by Plot for all graphs at once, then this only checks the cache
+  prepareGeometry();
+  if (_geometry.isEmpty()) return;
+
+  QCPSelectionDecorator* selectionDecorator = _selectionOnOverlay ? nullptr : activeSelectionDecorator();
+
+  // loop over and draw segments of unselected/selected data:
+  for (const SegmentGeometry &segment : std::as_const(_geometry))
+    drawSegment(painter, segment, segment.selected ? selectionDecorator : nullptr);
+
   // draw other selection decoration that isn't just line/scatter pens and brushes:
   if (selectionDecorator)
     selectionDecorator->drawDecoration(painter, selection());
 }
 
+void LineGraph::drawSelection(QCPPainter *painter)
+{
+  if (!_selectionOnOverlay || !selected() || !realVisibility()) return;
+  if (!mKeyAxis || !mValueAxis) return;
+
+  QCPSelectionDecorator* selectionDecorator = activeSelectionDecorator();
+  if (!selectionDecorator) return;
+
+  if (_draftPoints > 0 && painter->modes().testFlag(QCPPainter::pmNoCaching))
+  {
+    const int draftPoints = _draftPoints;
+    _draftPoints = 0;
+    drawSelection(painter);
+    _draftPoints = draftPoints;
+    return;
+  }
+
+  prepareGeometry();
+
+  // the same painter setup as QCPLayer::draw() does for graphs on their own layer
+  painter->save();
+  painter->setClipRect(clipRect().translated(0, -1));
+  applyDefaultAntialiasingHint(painter);
+
+  // selected segments are drawn entirely, the graph line has to be above the selection pen
+  for (const SegmentGeometry &segment : std::as_const(_geometry))
+    if (segment.selected)
+      drawSegment(painter, segment, selectionDecorator);
+
+  selectionDecorator->drawDecoration(painter, selection());
+  painter->restore();
+}
+
+void LineGraph::drawSegment(QCPPainter *painter, const SegmentGeometry &segment, QCPSelectionDecorator *selectionDecorator) const
+{
+  const QVector<QPointF> &lines = segment.lines;
+  const QVector<QPointF> &scatters = segment.scatters;
+
+  // draw selection:
+  if (selectionDecorator && selectionDecorator->pen() != Qt::NoPen)
+  {
+    QPen selectionPen(selectionDecorator->pen());
+    if (mLineStyle != lsNone)
+    {
+      selectionPen.setWidth(mPen.width() + 2*selectionDecorator->pen().width());
+      selectionPen.setCapStyle(Qt::RoundCap);
+    }
+
+    painter->setPen(selectionPen);
+    painter->setBrush(Qt::NoBrush);
+
+    drawLinePlot(painter, lines);
+  }
+
+  // draw line:
+  if (mLineStyle != lsNone)
+  {
+    painter->setPen(mPen);
+    painter->setBrush(Qt::NoBrush);
+
+    drawLinePlot(painter, lines); // also step plots can be drawn as a line plot
+  }
+
+  // draw scatters:
+  if (!mScatterStyle.isNone() && !_linesOnly)
+    drawScatterPlot(painter, scatters, mScatterStyle);
+
+  // draw selection:
+  if (selectionDecorator && !selectionDecorator->scatterStyle().isNone())
+    drawScatterPlot(painter, segment.handles, selectionDecorator->scatterStyle());
+}
+
+void LineGraph::drawLinePlot(QCPPainter *painter, const QVector<QPointF> &lines) const
+{
+  if (painter->pen().style() != Qt::NoPen && painter->pen().color().alpha() != 0)
+  {
+    applyDefaultAntialiasingHint(painter);
+    if (_fastLineRaster && drawThinPolyline(painter, lines))
+      return;
+    drawPolyline(painter, lines);
+  }
+}
+
+void LineGraph::drawScatterPlot(QCPPainter *painter, const QVector<QPointF> &scatters, const QCPScatterStyle &style) const
+{
+  applyScattersAntialiasingHint(painter);
+  style.applyTo(painter, mPen);
+  if (_scatterStamps && drawScatterStamps(painter, scatters, style))
+    return;
+  for (const QPointF &scatter : scatters)
+    style.drawShape(painter, scatter.x(), scatter.y());
+}
+
+//------------------------------------------------------------------------------
+//                              SelectionOverlay
+//------------------------------------------------------------------------------
+
+SelectionOverlay::SelectionOverlay(QCustomPlot *plot, const QString &layerName) : QCPLayerable(plot, layerName)
+{
+}
+
+void SelectionOverlay::applyDefaultAntialiasingHint(QCPPainter *painter) const
+{
+    Q_UNUSED(painter)
+}
+
+void SelectionOverlay::draw(QCPPainter *painter)
+{
+    auto plot = parentPlot();
+    for (int i = 0; i < plot->graphCount(); i++)
+        if (auto g = dynamic_cast<LineGraph*>(plot->graph(i)); g)
+            g->drawSelection(painter);
+}
+
 } // namespace QCPL
@@ -1,10 +1,21 @@
 #ifndef QCPL_GRAPH_H
 #define QCPL_GRAPH_H
 
-#include "qcustomplot/qcustomplot.h"
+#include "qcpl_graph_data.h"
+#include "qcpl_graph_lod.h"
 
 namespace QCPL {
 
+/// Makes a graph data container taking ownership on the source arrays.
+/// The source arrays are released as soon as their points are transferred into the container,
+/// so there are never more than two copies of the data alive.
+/// When @a sorted is true the caller guarantees ascending keys and they are neither checked nor sorted.
+QSharedPointer<QCPGraphDataContainer> makeGraphData(GraphData &&data, bool sorted = false);
+
+/// Makes a graph data container from raw key and value arrays of @a count points each.
+/// When @a sorted is true the caller guarantees ascending keys and they are neither checked nor sorted.
+QSharedPointer<QCPGraphDataContainer> makeGraphData(const double *keys, const double *values, int count, bool sorted = false);
+
 class LineGraph : public QCPGraph
 {
 public:
@@ -13,11 +24,224 @@ public:
     static QCPSelectionDecorator* sharedSelectionDecorator() { return _sharedSelectionDecorator; }
     static void setSharedSelectionDecorator(QCPSelectionDecorator* decorator);
 
+    /// Placement of selector handles, i.e. scatters of the selection decorator, on selected segments
+    struct SelectorHandles
+    {
+        enum Distribution
+        {
+            ByIndex, ///< Evenly spaced indices of visible data points
+            ByKey,   ///< Evenly spaced along the visible key range, snapped to the nearest next data point
+        };
+
+        /// Max number of handles per selected segment, zero hides them
+        int maxCount = 20;
+        Distribution distribution = ByIndex;
+    };
+    static const SelectorHandles& selectorHandles() { return _selectorHandles; }
+    static void setSelectorHandles(const SelectorHandles &handles);
+
+    /// Max number of points the graph keeps when data is streamed via appendData().
+    /// Zero means the history is unlimited. While old points are dropped, auto-squeeze of the data container
+    /// is disabled, it's restored when the limit is reset to zero or the data is replaced via setData().
+    int maxPointCount() const { return _maxPointCount; }
+    void setMaxPointCount(int count);
+
+    /// Appends points in streaming mode, keys should be ascending and not less than those already in the graph.
+    /// The cost is proportional to the number of new points, not to the history size.
+    /// Enabling LOD (see setLodEnabled()) is recommended for streamed graphs, then replots only process
+    /// the new tail, otherwise adaptive sampling rescans all the visible points on each replot.
+    /// Points out of order are merged into the data, which costs as much as QCPGraph::addData().
+    /// When the point count exceeds maxPointCount() the oldest points are dropped.
+    void appendData(const double *keys, const double *values, int count);
+    void appendData(const ValueArray &keys, const ValueArray &values);
+
+    /// These hide the QCPGraph ones to drop all the data caches after the data is changed, see invalidateDataCache().
+    /// Caches can't be validated by the container address, a new container can take the address of a freed one,
+    /// and the point count doesn't change when points are recalculated in place.
+    /// QCPGraph methods are not virtual, so the caches still must be invalidated when they are called via QCPGraph*.
+    void setData(QSharedPointer<QCPGraphDataContainer> data);
+    void setData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted = false);
+    void addData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted = false);
+    void addData(double key, double value);
+
+    /// Optional point storage used instead of the graph's own data container.
+    /// When a source is set, the container is cleared and all the QCPGraph machinery
+    /// (ranges, selection, drawing) works on the source. Set a null source to return to the container.
+    QSharedPointer<GraphDataSource> dataSource() const { return _dataSource; }
+    void setDataSource(const QSharedPointer<GraphDataSource> &source);
+
+    /// When enabled, the graph keeps a min/max pyramid of its values (see MinMaxPyramid)
+    /// and draws lines from the coarsest level still giving at least two buckets per pixel.
+    /// Then drawing cost depends on the plot width rather than on the number of visible points.
+    /// Works only together with adaptive sampling, the pyramid is built on the first draw.
+    bool lodEnabled() const { return _lodEnabled; }
+    void setLodEnabled(bool on);
+
+    /// The graph caches its key and value bounds (for all sign domains), the LOD pyramid and pixel geometry.
+    /// Call this after data points were changed in place via data() or via QCPGraph* pointer.
+    /// LineGraph's setData(), addData(), appendData(), and setDataSource() are tracked automatically.
+    void invalidateDataCache();
+
+    /// Computes pixel coordinates of lines and scatters for the next draw(), which then only paints them.
+    /// Different graphs can be prepared concurrently, Plot does this for all visible graphs before each replot.
+    /// Geometry is cached and only recalculated when data, axes, or line style change,
+    /// so replots caused by selection, legend, or title changes don't touch the data.
+    void prepareGeometry();
+
+    /// When positive, geometry is a coarse approximation made of at most this many points per segment,
+    /// evenly taken from its visible part, instead of the exact one. Plot uses this for progressive rendering.
+    int draftPoints() const { return _draftPoints; }
+    void setDraftPoints(int count);
+
+    /// When enabled, the graph draws only its line skipping scatters, without changing its scatter style.
+    /// Plot uses this to speed up frames during pan and zoom.
+    bool linesOnly() const { return _linesOnly; }
+    void setLinesOnly(bool on);
+
+    /// Number of data points within the key axis range, it's found without scanning the data.
+    int visiblePointCount() const;
+
+    /// Returns true if the exact geometry for the current data and axes is already prepared.
+    bool hasExactGeometry() const;
+
+    /// When enabled, draw() paints only the graph itself, and selection highlights and selector handles
+    /// are painted by drawSelection() called from SelectionOverlay. Then a selection change
+    /// only requires to repaint the overlay layer instead of all the graphs data.
+    bool selectionOnOverlay() const { return _selectionOnOverlay; }
+    void setSelectionOnOverlay(bool on);
+
+    /// When enabled, lines drawn with solid pen 1 device pixel wide are rasterized by drawThinPolyline()
+    /// directly into the layer image, which is much faster for dense lines of many thousands of segments.
+    /// Other pens, vector export, and OpenGL always go through QPainter. Enabled by default.
+    bool fastLineRaster() const { return _fastLineRaster; }
+    void setFastLineRaster(bool on);
+
+    /// When enabled, scatter markers are rendered once into a cached pixmap by drawScatterStamps()
+    /// and then blitted at each point instead of painting every shape via QPainter.
+    /// Markers are snapped to whole device pixels then. Enabled by default.
+    bool scatterStamps() const { return _scatterStamps; }
+    void setScatterStamps(bool on);
+
+    /// Paints selected segments together with their selection highlight, if selection is drawn on overlay.
+    void drawSelection(QCPPainter *painter);
+
+    double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details = nullptr) const override;
+    QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain = QCP::sdBoth) const override;
+    QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain = QCP::sdBoth, const QCPRange &inKeyRange = QCPRange()) const override;
+
+    int dataCount() const override;
+    double dataMainKey(int index) const override;
+    double dataSortKey(int index) const override;
+    double dataMainValue(int index) const override;
+    QCPRange dataValueRange(int index) const override;
+    QPointF dataPixelPosition(int index) const override;
+    int findBegin(double sortKey, bool expandedRange = true) const override;
+    int findEnd(double sortKey, bool expandedRange = true) const override;
+    QCPDataSelection selectTestRect(const QRectF &rect, bool onlySelectable) const override;
+
 protected:
     void draw(QCPPainter *painter) override;
+    void getOptimizedLineData(QVector<QCPGraphData> *lineData, const QCPGraphDataContainer::const_iterator &begin, const QCPGraphDataContainer::const_iterator &end) const override;
+    void drawLinePlot(QCPPainter *painter, const QVector<QPointF> &lines) const override;
+    void drawScatterPlot(QCPPainter *painter, const QVector<QPointF> &scatters, const QCPScatterStyle &style) const override;
 
 private:
     static QCPSelectionDecorator* _sharedSelectionDecorator;
+    static SelectorHandles _selectorHandles;
+    int _maxPointCount = 0;
+    int _droppedPointCount = 0;
+    // Auto-squeeze of the data container before dropOldPoints() disabled it
+    bool _squeezeDisabled = false;
+    bool _savedAutoSqueeze = true;
+    QSharedPointer<GraphDataSource> _dataSource;
+    bool _lodEnabled = false;
+    bool _selectionOnOverlay = false;
+    bool _fastLineRaster = true;
+    bool _scatterStamps = true;
+    int _draftPoints = 0;
+    bool _linesOnly = false;
+    mutable MinMaxPyramid _lod;
+    mutable const void *_lodData = nullptr;
+
+    struct CachedRange
+    {
+        QCPRange range;
+        bool found = false;
+        bool valid = false;
+    };
+    // Indexed by QCP::SignDomain
+    mutable CachedRange _keyBounds[3];
+    mutable CachedRange _valueBounds[3];
+    mutable const void *_boundsData = nullptr;
+    mutable int _boundsSize = 0;
+
+    // Everything pixel coordinates of points depend on, besides the points themselves
+    struct GeometryKey
+    {
+        const QCPAxis *keyAxis = nullptr, *valueAxis = nullptr;
+        Qt::Orientation keyOrientation = Qt::Horizontal, valueOrientation = Qt::Vertical;
+        QCPRange keyRange, valueRange;
+        QRect keyAxisRect, valueAxisRect;
+        bool keyReversed = false, valueReversed = false;
+        QCPAxis::ScaleType keyScale = QCPAxis::stLinear, valueScale = QCPAxis::stLinear;
+        LineStyle lineStyle = lsNone;
+        bool adaptiveSampling = false;
+        bool lodEnabled = false;
+        int scatterSkip = 0;
+        int draftPoints = 0;
+        const void *data = nullptr;
+        int dataCount = 0;
+        quint64 dataVersion = 0;
+
+        bool operator ==(const GeometryKey &other) const;
+    };
+    struct SegmentGeometry
+    {
+        QCPDataRange lineRange;
+        QCPDataRange scatterRange;
+        bool selected = false;
+        bool hasLines = false;
+        bool hasScatters = false;
+        QVector<QPointF> lines;
+        QVector<QPointF> scatters;
+        QVector<QPointF> handles;
+    };
+    QVector<SegmentGeometry> _geometry;
+    GeometryKey _geometryKey;
+    quint64 _dataVersion = 0;
+
+    QCPSelectionDecorator* activeSelectionDecorator() const { return _sharedSelectionDecorator ? _sharedSelectionDecorator : mSelectionDecorator; }
+    void dropOldPoints();
+    void restoreAutoSqueeze();
+    void getSourceBounds(int &begin, int &end, const QCPDataRange &rangeRestriction) const;
+    void getIndexBounds(int &begin, int &end, const QCPDataRange &dataRange) const;
+    void getSourceLines(QVector<QPointF> *lines, const QCPDataRange &dataRange) const;
+    void getSourceScatters(QVector<QPointF> *scatters, const QCPDataRange &dataRange) const;
+    void getGraphLines(QVector<QPointF> *lines, const QCPDataRange &dataRange) const;
+    void getGraphScatters(QVector<QPointF> *scatters, const QCPDataRange &dataRange) const;
+    void getSelectorHandles(QVector<QPointF> *handles, const QCPDataRange &dataRange) const;
+    const void* dataId() const;
+    void ensureLod() const;
+    void syncBounds() const;
+    QCPRange calcValueRange(bool &foundRange, QCP::SignDomain signDomain, int begin, int end) const;
+    bool getDraftLineData(QVector<QCPGraphData> *lineData, int begin, int end) const;
+    bool getLodLineData(QVector<QCPGraphData> *lineData, int begin, int end) const;
+    GeometryKey geometryKey() const;
+    void drawSegment(QCPPainter *painter, const SegmentGeometry &segment, QCPSelectionDecorator *selectionDecorator) const;
+};
+
+/**
+    Draws selection of all graphs having LineGraph::selectionOnOverlay() enabled.
+    It should be placed on a buffered layer above the graphs' layer.
+*/
+class SelectionOverlay : public QCPLayerable
+{
+public:
+    explicit SelectionOverlay(QCustomPlot *plot, const QString &layerName);
+
+protected:
+    void applyDefaultAntialiasingHint(QCPPainter *painter) const override;
+    void draw(QCPPainter *painter) override;
 };
 
 } // namespace QCPL
@@ -0,0 +1,12 @@
+#include "qcpl_graph_data.h"
+
+namespace QCPL {
+
+template class TypedGraphData<double, double>;
+template class TypedGraphData<double, float>;
+template class TypedGraphData<float, float>;
+template class TypedGraphData<double, qint16>;
+template class TypedGraphData<double, quint16>;
+template class TypedGraphData<double, qint32>;
+
+} // namespace QCPL
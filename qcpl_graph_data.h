@@ -0,0 +1,391 @@
+#ifndef QCPL_GRAPH_DATA_H
+#define QCPL_GRAPH_DATA_H
+
+#include "qcpl_simd.h"
+#include "qcpl_types.h"
+#include "qcustomplot/qcustomplot.h"
+
+#include <cmath>
+#include <numeric>
+
+namespace QCPL {
+
+/**
+    Point storage that LineGraph can use instead of QCPGraphDataContainer.
+    Keys are expected to be sorted ascending.
+*/
+class GraphDataSource
+{
+public:
+    virtual ~GraphDataSource() {}
+
+    virtual int size() const = 0;
+    virtual double key(int index) const = 0;
+    virtual double value(int index) const = 0;
+
+    bool isEmpty() const { return size() == 0; }
+
+    /// Returns index of the point having a key equal to or just below @a key
+    /// (or just above it if @a expandedRange is false), the same as QCPDataContainer::findBegin() does.
+    virtual int findBegin(double key, bool expandedRange = true) const = 0;
+
+    /// Returns index after the point having a key equal to or just above @a key
+    /// (or just below it if @a expandedRange is false), the same as QCPDataContainer::findEnd() does.
+    virtual int findEnd(double key, bool expandedRange = true) const = 0;
+
+    virtual QCPRange keyRange(bool &foundRange, QCP::SignDomain signDomain) const = 0;
+    virtual QCPRange valueRange(bool &foundRange, QCP::SignDomain signDomain, int begin, int end) const = 0;
+
+    /// Fills @a lineData with points of index range [@a begin, @a end) to be drawn as graph line.
+    /// With @a adaptiveSampling points falling into the same pixel are reduced to their min/max,
+    /// the same way as QCPGraph::getOptimizedLineData() does.
+    virtual void getLineData(QVector<QCPGraphData> *lineData, int begin, int end, const QCPAxis *keyAxis, bool adaptiveSampling) const = 0;
+};
+
+/// Fills @a lineData with points of index range [@a begin, @a end) for drawing them as a graph line,
+/// @a keyAt(i) and @a valueAt(i) should return key and value of the i-th point.
+/// With @a adaptiveSampling points falling into the same pixel are reduced to their min/max,
+/// the same way as QCPGraph::getOptimizedLineData() does.
+template <typename KeyAt, typename ValueAt>
+void sampleLineData(QVector<QCPGraphData> *lineData, int begin, int end, const QCPAxis *keyAxis, bool adaptiveSampling, KeyAt keyAt, ValueAt valueAt)
+{
+    if (!lineData) return;
+    lineData->clear();
+    begin = qMax(begin, 0);
+    if (begin >= end) return;
+
+    int dataCount = end - begin;
+    int maxCount = (std::numeric_limits<int>::max)();
+    if (adaptiveSampling)
+    {
+        double keyPixelSpan = qAbs(keyAxis->coordToPixel(keyAt(begin)) - keyAxis->coordToPixel(keyAt(end-1)));
+        if (2*keyPixelSpan+2 < static_cast<double>((std::numeric_limits<int>::max)()))
+            maxCount = int(2*keyPixelSpan+2);
+    }
+
+    // Don't use adaptive sampling if there are less than two points per pixel on average
+    if (!adaptiveSampling || dataCount < maxCount)
+    {
+        lineData->resize(dataCount);
+        QCPGraphData *p = lineData->data();
+        for (int i = 0; i < dataCount; i++)
+        {
+            p[i].key = keyAt(begin+i);
+            p[i].value = valueAt(begin+i);
+        }
+        return;
+    }
+
+    // The same algorithm as in QCPGraph::getOptimizedLineData() but working on any point storage
+    double minValue = valueAt(begin);
+    double maxValue = minValue;
+    int intervalFirstPoint = begin;
+    int reversedFactor = keyAxis->pixelOrientation(); // is used to calculate keyEpsilon pixel into the correct direction
+    int reversedRound = reversedFactor==-1 ? 1 : 0; // is used to switch between floor (normal) and ceil (reversed) rounding of intervalStartKey
+    double intervalStartKey = keyAxis->pixelToCoord(int(keyAxis->coordToPixel(keyAt(begin))+reversedRound));
+    double lastIntervalEndKey = intervalStartKey;
+    double keyEpsilon = qAbs(intervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(intervalStartKey)+1.0*reversedFactor)); // interval of one pixel on screen when mapped to plot key coordinates
+    bool keyEpsilonVariable = keyAxis->scaleType() == QCPAxis::stLogarithmic; // indicates whether keyEpsilon needs to be updated after every interval (for log axes)
+    int intervalDataCount = 1;
+    for (int i = begin+1; i < end; i++)
+    {
+        const double key = keyAt(i);
+        const double value = valueAt(i);
+        if (key < intervalStartKey+keyEpsilon) // data point is still within same pixel, so skip it and expand value span of this cluster if necessary
+        {
+            if (value < minValue)
+                minValue = value;
+            else if (value > maxValue)
+                maxValue = value;
+            ++intervalDataCount;
+        }
+        else // new pixel interval started
+        {
+            if (intervalDataCount >= 2) // last pixel had multiple data points, consolidate them to a cluster
+            {
+                if (lastIntervalEndKey < intervalStartKey-keyEpsilon) // last point is further away, so first point of this cluster must be at a real data point
+                    lineData->append(QCPGraphData(intervalStartKey+keyEpsilon*0.2, valueAt(intervalFirstPoint)));
+                lineData->append(QCPGraphData(intervalStartKey+keyEpsilon*0.25, minValue));
+                lineData->append(QCPGraphData(intervalStartKey+keyEpsilon*0.75, maxValue));
+                if (key > intervalStartKey+keyEpsilon*2) // new pixel started further away from previous cluster, so make sure the last point of the cluster is at a real data point
+                    lineData->append(QCPGraphData(intervalStartKey+keyEpsilon*0.8, valueAt(i-1)));
+            }
+            else
+                lineData->append(QCPGraphData(keyAt(intervalFirstPoint), valueAt(intervalFirstPoint)));
+            lastIntervalEndKey = keyAt(i-1);
+            minValue = value;
+            maxValue = value;
+            intervalFirstPoint = i;
+            intervalStartKey = keyAxis->pixelToCoord(int(keyAxis->coordToPixel(key)+reversedRound));
+            if (keyEpsilonVariable)
+                keyEpsilon = qAbs(intervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(intervalStartKey)+1.0*reversedFactor));
+            intervalDataCount = 1;
+        }
+    }
+    // handle last interval:
+    if (intervalDataCount >= 2) // last pixel had multiple data points, consolidate them to a cluster
+    {
+        if (lastIntervalEndKey < intervalStartKey-keyEpsilon) // last point wasn't a cluster, so first point of this cluster must be at a real data point
+            lineData->append(QCPGraphData(intervalStartKey+keyEpsilon*0.2, valueAt(intervalFirstPoint)));
+        lineData->append(QCPGraphData(intervalStartKey+keyEpsilon*0.25, minValue));
+        lineData->append(QCPGraphData(intervalStartKey+keyEpsilon*0.75, maxValue));
+    }
+    else
+        lineData->append(QCPGraphData(keyAt(intervalFirstPoint), valueAt(intervalFirstPoint)));
+}
+
+/**
+    Structure-of-arrays point storage: keys and values are kept in separate contiguous arrays.
+    So key-only searches and value-only reductions touch only the half of memory
+    and compilers can vectorize them.
+
+    Samples are stored in their native types (e.g. float or qint16 ADC counts)
+    and converted to double only when they are requested, i.e. at the pixel-mapping stage.
+    Values can be additionally transformed as raw*scale + offset, e.g. to get volts from ADC counts.
+*/
+template <typename KeyT, typename ValueT>
+class TypedGraphData : public GraphDataSource
+{
+public:
+    typedef KeyT KeyType;
+    typedef ValueT ValueType;
+
+    TypedGraphData() {}
+
+    /// The arrays are implicitly shared, so this doesn't copy them
+    TypedGraphData(QVector<KeyT> keys, QVector<ValueT> values, bool sorted = false);
+    explicit TypedGraphData(GraphDataT<KeyT, ValueT> &&data, bool sorted = false)
+        : TypedGraphData(std::move(data.x), std::move(data.y), sorted) {}
+
+    const QVector<KeyT>& keys() const { return _keys; }
+    const QVector<ValueT>& values() const { return _values; }
+
+    double valueScale() const { return _valueScale; }
+    double valueOffset() const { return _valueOffset; }
+    /// The @a scale must be finite and non-zero, otherwise the transform is rejected.
+    void setValueTransform(double scale, double offset);
+
+    int size() const override { return _size; }
+    double key(int index) const override { return keyAt(index); }
+    double value(int index) const override { return valueAt(index); }
+    int findBegin(double key, bool expandedRange = true) const override;
+    int findEnd(double key, bool expandedRange = true) const override;
+    QCPRange keyRange(bool &foundRange, QCP::SignDomain signDomain) const override;
+    QCPRange valueRange(bool &foundRange, QCP::SignDomain signDomain, int begin, int end) const override;
+    void getLineData(QVector<QCPGraphData> *lineData, int begin, int end, const QCPAxis *keyAxis, bool adaptiveSampling) const override;
+
+private:
+    QVector<KeyT> _keys;
+    QVector<ValueT> _values;
+    int _size = 0;
+    double _valueScale = 1;
+    double _valueOffset = 0;
+
+    double keyAt(int index) const { return double(_keys.constData()[index]); }
+    double valueAt(int index) const { return double(_values.constData()[index])*_valueScale + _valueOffset; }
+    int lowerBound(double key) const;
+    int upperBound(double key) const;
+};
+
+/**
+    Point storage of double keys and values.
+*/
+class ColumnarGraphData : public TypedGraphData<double, double>
+{
+public:
+    using TypedGraphData::TypedGraphData;
+
+    explicit ColumnarGraphData(GraphData &&data, bool sorted = false)
+        : TypedGraphData(std::move(data.x), std::move(data.y), sorted) {}
+};
+
+/// Makes a graph data source taking ownership on typed sample arrays.
+template <typename KeyT, typename ValueT>
+QSharedPointer<GraphDataSource> makeGraphDataSource(GraphDataT<KeyT, ValueT> &&data, bool sorted = false)
+{
+    return QSharedPointer<GraphDataSource>(new TypedGraphData<KeyT, ValueT>(std::move(data), sorted));
+}
+
+//------------------------------------------------------------------------------
+//                              TypedGraphData
+//------------------------------------------------------------------------------
+
+template <typename KeyT, typename ValueT>
+TypedGraphData<KeyT, ValueT>::TypedGraphData(QVector<KeyT> keys, QVector<ValueT> values, bool sorted)
+    : _keys(std::move(keys)), _values(std::move(values))
+{
+    if (_keys.size() != _values.size())
+        qWarning() << Q_FUNC_INFO << "keys and values have different sizes:" << _keys.size() << _values.size();
+    _size = qMin(_keys.size(), _values.size());
+
+    if (sorted || std::is_sorted(_keys.constBegin(), _keys.constBegin() + _size))
+        return;
+
+    QVector<int> order(_size);
+    std::iota(order.begin(), order.end(), 0);
+    const KeyT *k = _keys.constData();
+    std::stable_sort(order.begin(), order.end(), [k](int a, int b){ return k[a] < k[b]; });
+    QVector<KeyT> sortedKeys(_size);
+    QVector<ValueT> sortedValues(_size);
+    for (int i = 0; i < _size; i++)
+    {
+        sortedKeys[i] = _keys.at(order.at(i));
+        sortedValues[i] = _values.at(order.at(i));
+    }
+    _keys = sortedKeys;
+    _values = sortedValues;
+}
+
+template <typename KeyT, typename ValueT>
+void TypedGraphData<KeyT, ValueT>::setValueTransform(double scale, double offset)
+{
+    // Value ranges are reduced against the raw zero threshold -offset/scale
+    if (scale == 0 || !std::isfinite(scale))
+    {
+        qWarning() << Q_FUNC_INFO << "invalid value scale:" << scale;
+        return;
+    }
+    _valueScale = scale;
+    _valueOffset = offset;
+}
+
+template <typename KeyT, typename ValueT>
+int TypedGraphData<KeyT, ValueT>::lowerBound(double key) const
+{
+    const KeyT *k = _keys.constData();
+    return int(std::lower_bound(k, k + _size, key, [](KeyT a, double b){ return double(a) < b; }) - k);
+}
+
+template <typename KeyT, typename ValueT>
+int TypedGraphData<KeyT, ValueT>::upperBound(double key) const
+{
+    const KeyT *k = _keys.constData();
+    return int(std::upper_bound(k, k + _size, key, [](double a, KeyT b){ return a < double(b); }) - k);
+}
+
+template <typename KeyT, typename ValueT>
+int TypedGraphData<KeyT, ValueT>::findBegin(double key, bool expandedRange) const
+{
+    if (_size == 0) return 0;
+    int index = lowerBound(key);
+    if (expandedRange && index > 0)
+        index--;
+    return index;
+}
+
+template <typename KeyT, typename ValueT>
+int TypedGraphData<KeyT, ValueT>::findEnd(double key, bool expandedRange) const
+{
+    if (_size == 0) return 0;
+    int index = upperBound(key);
+    if (expandedRange && index < _size)
+        index++;
+    return index;
+}
+
+template <typename KeyT, typename ValueT>
+QCPRange TypedGraphData<KeyT, ValueT>::keyRange(bool &foundRange, QCP::SignDomain signDomain) const
+{
+    foundRange = false;
+    if (_size == 0) return QCPRange();
+
+    // Keys are sorted, so there is no need to scan them
+    int begin = 0, end = _size;
+    if (signDomain == QCP::sdPositive)
+        begin = upperBound(0);
+    else if (signDomain == QCP::sdNegative)
+        end = lowerBound(0);
+    if (begin >= end) return QCPRange();
+
+    foundRange = true;
+    return QCPRange(keyAt(begin), keyAt(end-1));
+}
+
+template <typename KeyT, typename ValueT>
+QCPRange TypedGraphData<KeyT, ValueT>::valueRange(bool &foundRange, QCP::SignDomain signDomain, int begin, int end) const
+{
+    begin = qMax(begin, 0);
+    end = qMin(end, _size);
+    const ValueT *v = _values.constData();
+
+    // The raw samples are reduced in their own type, the transform is monotonic
+    // so it's only applied to the found extremes (with the swap for negative scale).
+    // Sign domains are checked on transformed values, so they are reduced against the raw threshold.
+    double lower = std::numeric_limits<double>::infinity();
+    double upper = -lower;
+    const double zero = (0 - _valueOffset) / _valueScale;
+    const bool negativeScale = _valueScale < 0;
+    bool checkAbove = signDomain == QCP::sdPositive;
+    bool checkBelow = signDomain == QCP::sdNegative;
+    if (negativeScale) std::swap(checkAbove, checkBelow);
+    // Infinite samples are skipped as findMinMax() and QCPGraph do, integer samples are always finite
+    constexpr bool checkFinite = std::is_floating_point<ValueT>::value;
+    if constexpr (std::is_same<ValueT, double>::value)
+    {
+        const auto rawDomain = checkAbove ? QCP::sdPositive : (checkBelow ? QCP::sdNegative : QCP::sdBoth);
+        if (end > begin)
+            findMinMax(v + begin, end - begin, 1, rawDomain, lower, upper, zero);
+    }
+    // NaNs fail all the comparisons and are skipped naturally, infinities are not
+    else if (checkAbove)
+    {
+        for (int i = begin; i < end; i++)
+        {
+            const double x = double(v[i]);
+            if (checkFinite && !std::isfinite(x)) continue;
+            if (x > zero)
+            {
+                if (x < lower) lower = x;
+                if (x > upper) upper = x;
+            }
+        }
+    }
+    else if (checkBelow)
+    {
+        for (int i = begin; i < end; i++)
+        {
+            const double x = double(v[i]);
+            if (checkFinite && !std::isfinite(x)) continue;
+            if (x < zero)
+            {
+                if (x < lower) lower = x;
+                if (x > upper) upper = x;
+            }
+        }
+    }
+    else
+    {
+        for (int i = begin; i < end; i++)
+        {
+            const double x = double(v[i]);
+            if (checkFinite && !std::isfinite(x)) continue;
+            if (x < lower) lower = x;
+            if (x > upper) upper = x;
+        }
+    }
+    foundRange = lower <= upper;
+    if (!foundRange) return QCPRange();
+    lower = lower*_valueScale + _valueOffset;
+    upper = upper*_valueScale + _valueOffset;
+    if (negativeScale) std::swap(lower, upper);
+    return QCPRange(lower, upper);
+}
+
+template <typename KeyT, typename ValueT>
+void TypedGraphData<KeyT, ValueT>::getLineData(QVector<QCPGraphData> *lineData, int begin, int end, const QCPAxis *keyAxis, bool adaptiveSampling) const
+{
+    sampleLineData(lineData, begin, qMin(end, _size), keyAxis, adaptiveSampling,
+                   [this](int i){ return keyAt(i); }, [this](int i){ return valueAt(i); });
+}
+
+// The most common sample types are compiled once in qcpl_graph_data.cpp
+extern template class TypedGraphData<double, double>;
+extern template class TypedGraphData<double, float>;
+extern template class TypedGraphData<float, float>;
+extern template class TypedGraphData<double, qint16>;
+extern template class TypedGraphData<double, quint16>;
+extern template class TypedGraphData<double, qint32>;
+
+} // namespace QCPL
+
+#endif // QCPL_GRAPH_DATA_H
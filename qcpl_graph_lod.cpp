@@ -0,0 +1,117 @@
+#include "qcpl_graph_lod.h"
+
+namespace QCPL {
+
+//------------------------------------------------------------------------------
+//                               MinMaxPyramid
+//------------------------------------------------------------------------------
+
+void MinMaxPyramid::clear()
+{
+    _levels.clear();
+    _offset = 0;
+    _size = 0;
+}
+
+void MinMaxPyramid::merge(Bucket &target, double value)
+{
+    if (value < target.min || qIsNaN(target.min)) target.min = value;
+    if (value > target.max || qIsNaN(target.max)) target.max = value;
+}
+
+void MinMaxPyramid::merge(Bucket &target, const Bucket &source)
+{
+    if (source.min < target.min || qIsNaN(target.min)) target.min = source.min;
+    if (source.max > target.max || qIsNaN(target.max)) target.max = source.max;
+}
+
+int MinMaxPyramid::levelFor(double maxBucketSize) const
+{
+    for (int level = _levels.size()-1; level >= 0; level--)
+        if (double(qint64(1) << levelShift(level)) <= maxBucketSize)
+            return level;
+    return -1;
+}
+
+const MinMaxPyramid::Bucket& MinMaxPyramid::bucket(int level, int pointIndex) const
+{
+    const Level &lv = _levels.at(level);
+    return lv.buckets.at(int(((pointIndex + _offset) >> levelShift(level)) - lv.firstBucket));
+}
+
+int MinMaxPyramid::bucketStart(int level, int pointIndex) const
+{
+    const int shift = levelShift(level);
+    return int((((pointIndex + _offset) >> shift) << shift) - _offset);
+}
+
+void MinMaxPyramid::append(double value)
+{
+    if (_levels.isEmpty())
+        _levels.append(Level());
+
+    const qint64 index = _offset + _size;
+    for (int level = 0; level < _levels.size(); level++)
+    {
+        Level &lv = _levels[level];
+        const qint64 b = index >> levelShift(level);
+        if (lv.buckets.isEmpty())
+            lv.firstBucket = b;
+        const int pos = int(b - lv.firstBucket);
+        if (pos == lv.buckets.size())
+            lv.buckets.append({ value, value });
+        else
+            merge(lv.buckets[pos], value);
+    }
+    _size++;
+
+    addLevelIfNeeded();
+}
+
+void MinMaxPyramid::addLevelIfNeeded()
+{
+    while (_levels.last().buckets.size() - _levels.last().deadCount > 2)
+    {
+        const Level &top = _levels.last();
+        Level next;
+        next.firstBucket = (top.firstBucket + top.deadCount) >> 1;
+        for (int i = top.deadCount; i < top.buckets.size(); i++)
+        {
+            const int pos = int(((top.firstBucket + i) >> 1) - next.firstBucket);
+            if (pos == next.buckets.size())
+                next.buckets.append(top.buckets.at(i));
+            else
+                merge(next.buckets[pos], top.buckets.at(i));
+        }
+        _levels.append(next);
+    }
+}
+
+void MinMaxPyramid::dropFront(int count)
+{
+    count = qMin(count, _size);
+    if (count <= 0) return;
+
+    _size -= count;
+    if (_size == 0)
+    {
+        clear();
+        return;
+    }
+    _offset += count;
+
+    for (int level = 0; level < _levels.size(); level++)
+    {
+        Level &lv = _levels[level];
+        lv.deadCount = int((_offset >> levelShift(level)) - lv.firstBucket);
+        // Compacting only when the dead part dominates keeps it amortized O(1) per point
+        if (lv.deadCount > 0 && lv.deadCount >= lv.buckets.size() / 2)
+        {
+            lv.buckets.remove(0, lv.deadCount);
+            lv.firstBucket += lv.deadCount;
+            lv.deadCount = 0;
+        }
+    }
+}
+
+} // namespace QCPL
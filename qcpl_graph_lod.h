@@ -0,0 +1,148 @@
+#ifndef QCPL_GRAPH_LOD_H
+#define QCPL_GRAPH_LOD_H
+
+#include "qcustomplot/qcustomplot.h"
+
+namespace QCPL {
+
+/**
+    Multi-resolution min/max pyramid of graph values.
+
+    Level N keeps min and max value of every bucket of 2^(firstLevelShift+N) consecutive points,
+    so a visible range of any size can be summarized by walking only a few buckets per pixel.
+    Buckets are numbered from the first point ever added, so points can be appended
+    and dropped from the front (streaming mode) without rebuilding the pyramid.
+*/
+class MinMaxPyramid
+{
+public:
+    /// The finest level has 16 points per bucket, so the pyramid takes about 1/8 of the graph data memory.
+    static const int firstLevelShift = 4;
+
+    struct Bucket
+    {
+        double min;
+        double max;
+    };
+
+    bool isEmpty() const { return _size == 0; }
+
+    /// Number of points summarized in the pyramid
+    int size() const { return _size; }
+
+    int levelCount() const { return _levels.size(); }
+    int levelShift(int level) const { return firstLevelShift + level; }
+
+    /// Returns the coarsest level whose buckets contain not more than @a maxBucketSize points,
+    /// or -1 if even the finest level is too coarse.
+    int levelFor(double maxBucketSize) const;
+
+    /// Returns the bucket of @a level containing the point with index @a pointIndex.
+    const Bucket& bucket(int level, int pointIndex) const;
+
+    /// Returns index of the first point of the bucket containing the point @a pointIndex.
+    /// It can be negative when leading points of the bucket were dropped.
+    int bucketStart(int level, int pointIndex) const;
+
+    void clear();
+
+    /// Rebuilds the pyramid from scratch, @a valueAt(i) should return value of the i-th point.
+    template <typename ValueAt> void build(int count, ValueAt valueAt);
+
+    /// Adds a point after the last one, this is O(log N).
+    void append(double value);
+
+    /// Forgets @a count oldest points. Buckets that became empty are released eventually.
+    /// The first bucket of every level still accounts the dropped points until refreshFront() is called.
+    void dropFront(int count);
+
+    /// Recalculates the first bucket of every level from the remaining points, this is O(log N).
+    /// @a valueAt(i) should return value of the i-th remaining point.
+    template <typename ValueAt> void refreshFront(ValueAt valueAt);
+
+private:
+    struct Level
+    {
+        qint64 firstBucket = 0; // absolute index of the bucket stored at position 0
+        int deadCount = 0;      // number of leading buckets containing only dropped points
+        QVector<Bucket> buckets;
+    };
+    QVector<Level> _levels;
+    qint64 _offset = 0; // absolute index of the current first point
+    int _size = 0;
+
+    static void merge(Bucket &target, double value);
+    static void merge(Bucket &target, const Bucket &source);
+    void addLevelIfNeeded();
+};
+
+template <typename ValueAt> void MinMaxPyramid::build(int count, ValueAt valueAt)
+{
+    clear();
+    if (count <= 0) return;
+    const int bucketSize = 1 << firstLevelShift;
+
+    Level first;
+    first.buckets.resize((count + bucketSize - 1) >> firstLevelShift);
+    Bucket *b = first.buckets.data();
+    for (int i = 0, bi = 0; i < count; i += bucketSize, bi++)
+    {
+        double min = valueAt(i), max = min;
+        const int end = qMin(i + bucketSize, count);
+        for (int j = i + 1; j < end; j++)
+        {
+            const double v = valueAt(j);
+            // NaN always fails the comparisons and is skipped unless the bucket started with it
+            if (v < min || qIsNaN(min)) min = v;
+            if (v > max || qIsNaN(max)) max = v;
+        }
+        b[bi] = { min, max };
+    }
+    _levels.append(first);
+    _size = count;
+
+    // Every next level is reduced from the previous one, so the whole build is O(count)
+    while (_levels.last().buckets.size() > 2)
+    {
+        const QVector<Bucket> &prev = _levels.last().buckets;
+        Level next;
+        next.buckets.resize((prev.size() + 1) / 2);
+        for (int i = 0; i < prev.size(); i++)
+        {
+            if (i % 2 == 0)
+                next.buckets[i/2] = prev.at(i);
+            else
+                merge(next.buckets[i/2], prev.at(i));
+        }
+        _levels.append(next);
+    }
+}
+
+template <typename ValueAt> void MinMaxPyramid::refreshFront(ValueAt valueAt)
+{
+    if (_levels.isEmpty()) return;
+
+    // The first live bucket of the finest level is rescanned from its remaining points
+    Level &first = _levels[0];
+    const int end = qMin(_size, bucketStart(0, 0) + (1 << firstLevelShift));
+    Bucket b = { valueAt(0), valueAt(0) };
+    for (int i = 1; i < end; i++)
+        merge(b, valueAt(i));
+    first.buckets[first.deadCount] = b;
+
+    // The first live bucket of every next level merges the first one or two live buckets of the previous level
+    for (int level = 1; level < _levels.size(); level++)
+    {
+        const Level &prev = _levels.at(level-1);
+        Level &lv = _levels[level];
+        b = prev.buckets.at(prev.deadCount);
+        const bool hasPair = ((prev.firstBucket + prev.deadCount) & 1) == 0;
+        if (hasPair && prev.deadCount + 1 < prev.buckets.size())
+            merge(b, prev.buckets.at(prev.deadCount + 1));
+        lv.buckets[lv.deadCount] = b;
+    }
+}
+
+} // namespace QCPL
+
+#endif // QCPL_GRAPH_LOD_H
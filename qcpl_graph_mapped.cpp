@@ -0,0 +1,234 @@
+#include "qcpl_graph_mapped.h"
+
+#include <QFile>
+
+#include <cmath>
+
+namespace QCPL {
+
+//------------------------------------------------------------------------------
+//                              MappedGraphData
+//------------------------------------------------------------------------------
+
+MappedGraphData::MappedGraphData()
+{
+}
+
+MappedGraphData::~MappedGraphData()
+{
+    close();
+}
+
+void MappedGraphData::close()
+{
+    // Files unmap their memory when closed
+    _keysFile.reset();
+    _valuesFile.reset();
+    _keys = nullptr;
+    _values = nullptr;
+    _size = 0;
+}
+
+QString MappedGraphData::map(QFile *file, const uchar *&data, qint64 &sampleCount)
+{
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    Q_UNUSED(file)
+    Q_UNUSED(data)
+    Q_UNUSED(sampleCount)
+    return "Mapping of little-endian data files is not supported on this platform";
+#else
+    if (!file->open(QIODevice::ReadOnly))
+        return QString("Unable to open file %1: %2").arg(file->fileName(), file->errorString());
+    const int sampleSize = _type == Float64 ? sizeof(double) : sizeof(float);
+    if (file->size() % sampleSize != 0)
+        return QString("Size of file %1 is not a multiple of the sample size").arg(file->fileName());
+    sampleCount = file->size() / sampleSize;
+    if (sampleCount == 0)
+    {
+        data = nullptr;
+        return QString();
+    }
+    data = file->map(0, file->size());
+    if (!data)
+        return QString("Unable to map file %1: %2").arg(file->fileName(), file->errorString());
+    return QString();
+#endif
+}
+
+QString MappedGraphData::openInterleaved(const QString &fileName, SampleType type)
+{
+    close();
+    _type = type;
+    _stride = 2;
+    _valueShift = 1;
+    _implicitKeys = false;
+    _valuesFile.reset(new QFile(fileName));
+    qint64 sampleCount;
+    auto err = map(_valuesFile.data(), _values, sampleCount);
+    if (!err.isEmpty())
+    {
+        close();
+        return err;
+    }
+    if (sampleCount % 2 != 0)
+        qWarning() << Q_FUNC_INFO << "incomplete last record is ignored in" << fileName;
+    _keys = _values;
+    return setPointCount(sampleCount / 2, fileName);
+}
+
+QString MappedGraphData::openSeparate(const QString &keysFileName, const QString &valuesFileName, SampleType type)
+{
+    close();
+    _type = type;
+    _stride = 1;
+    _valueShift = 0;
+    _implicitKeys = false;
+    _keysFile.reset(new QFile(keysFileName));
+    _valuesFile.reset(new QFile(valuesFileName));
+    qint64 keyCount, valueCount;
+    auto err = map(_keysFile.data(), _keys, keyCount);
+    if (err.isEmpty())
+        err = map(_valuesFile.data(), _values, valueCount);
+    if (!err.isEmpty())
+    {
+        close();
+        return err;
+    }
+    if (keyCount != valueCount)
+        qWarning() << Q_FUNC_INFO << "keys and values have different sizes:" << keyCount << valueCount;
+    return setPointCount(qMin(keyCount, valueCount), valuesFileName);
+}
+
+QString MappedGraphData::openImplicitKeys(const QString &valuesFileName, SampleType type, double keyOffset, double keyStep)
+{
+    close();
+    if (keyStep <= 0)
+        return "Key step must be positive";
+    _type = type;
+    _stride = 1;
+    _valueShift = 0;
+    _implicitKeys = true;
+    _keyOffset = keyOffset;
+    _keyStep = keyStep;
+    _valuesFile.reset(new QFile(valuesFileName));
+    qint64 sampleCount;
+    auto err = map(_valuesFile.data(), _values, sampleCount);
+    if (!err.isEmpty())
+    {
+        close();
+        return err;
+    }
+    return setPointCount(sampleCount, valuesFileName);
+}
+
+QString MappedGraphData::setPointCount(qint64 count, const QString &fileName)
+{
+    // Graph data sources are indexed by int, the file is not truncated silently
+    if (count > std::numeric_limits<int>::max())
+    {
+        close();
+        return QString("File %1 has %2 points, at most %3 are supported")
+            .arg(fileName).arg(count).arg(std::numeric_limits<int>::max());
+    }
+    _size = int(count);
+    return QString();
+}
+
+int MappedGraphData::lowerBound(double key) const
+{
+    if (_implicitKeys)
+        return int(qBound(0.0, std::ceil((key - _keyOffset) / _keyStep), double(_size)));
+    int lo = 0, hi = _size;
+    while (lo < hi)
+    {
+        const int mid = lo + (hi - lo) / 2;
+        if (keyAt(mid) < key) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+int MappedGraphData::upperBound(double key) const
+{
+    if (_implicitKeys)
+        return int(qBound(0.0, std::floor((key - _keyOffset) / _keyStep) + 1, double(_size)));
+    int lo = 0, hi = _size;
+    while (lo < hi)
+    {
+        const int mid = lo + (hi - lo) / 2;
+        if (key < keyAt(mid)) hi = mid; else lo = mid + 1;
+    }
+    return lo;
+}
+
+int MappedGraphData::findBegin(double key, bool expandedRange) const
+{
+    if (_size == 0) return 0;
+    int index = lowerBound(key);
+    if (expandedRange && index > 0)
+        index--;
+    return index;
+}
+
+int MappedGraphData::findEnd(double key, bool expandedRange) const
+{
+    if (_size == 0) return 0;
+    int index = upperBound(key);
+    if (expandedRange && index < _size)
+        index++;
+    return index;
+}
+
+QCPRange MappedGraphData::keyRange(bool &foundRange, QCP::SignDomain signDomain) const
+{
+    foundRange = false;
+    if (_size == 0) return QCPRange();
+
+    // Keys are sorted, so there is no need to scan them
+    int begin = 0, end = _size;
+    if (signDomain == QCP::sdPositive)
+        begin = upperBound(0);
+    else if (signDomain == QCP::sdNegative)
+        end = lowerBound(0);
+    if (begin >= end) return QCPRange();
+
+    foundRange = true;
+    return QCPRange(keyAt(begin), keyAt(end-1));
+}
+
+QCPRange MappedGraphData::valueRange(bool &foundRange, QCP::SignDomain signDomain, int begin, int end) const
+{
+    begin = qMax(begin, 0);
+    end = qMin(end, _size);
+    double lower = std::numeric_limits<double>::infinity();
+    double upper = -lower;
+    if (begin < end)
+    {
+        if (_type == Float64)
+        {
+            const double *values = reinterpret_cast<const double*>(_values) + qint64(begin)*_stride + _valueShift;
+            findMinMax(values, end - begin, _stride, signDomain, lower, upper);
+        }
+        else
+        {
+            for (int i = begin; i < end; i++)
+            {
+                const double v = valueAt(i);
+                if (!std::isfinite(v)) continue;
+                if (signDomain == QCP::sdPositive && v <= 0) continue;
+                if (signDomain == QCP::sdNegative && v >= 0) continue;
+                if (v < lower) lower = v;
+                if (v > upper) upper = v;
+            }
+        }
+    }
+    foundRange = lower <= upper;
+    return foundRange ? QCPRange(lower, upper) : QCPRange();
+}
+
+void MappedGraphData::getLineData(QVector<QCPGraphData> *lineData, int begin, int end, const QCPAxis *keyAxis, bool adaptiveSampling) const
+{
+    sampleLineData(lineData, begin, qMin(end, _size), keyAxis, adaptiveSampling,
+                   [this](int i){ return keyAt(i); }, [this](int i){ return valueAt(i); });
+}
+
+} // namespace QCPL
@@ -0,0 +1,83 @@
+#ifndef QCPL_GRAPH_MAPPED_H
+#define QCPL_GRAPH_MAPPED_H
+
+#include "qcpl_graph_data.h"
+
+QT_BEGIN_NAMESPACE
+class QFile;
+QT_END_NAMESPACE
+
+namespace QCPL {
+
+/**
+    Graph data source reading points right from memory-mapped binary files.
+
+    Files are flat arrays of little-endian samples without any header.
+    Points can be stored as interleaved {key, value} records, as separate key and value files,
+    or as values only with keys calculated from an offset and a step.
+    Opening doesn't read the files, pages are loaded by the OS on access and can be evicted
+    under memory pressure, so memory use is bounded by the page cache rather than by the file size.
+    Keys are expected to be sorted ascending, it's not checked because that would require reading the whole file.
+*/
+class MappedGraphData : public GraphDataSource
+{
+public:
+    enum SampleType { Float64, Float32 };
+
+    MappedGraphData();
+    ~MappedGraphData();
+
+    /// These functions return an error message or empty string on success.
+    /// Files having more points than fit into int are rejected.
+    QString openInterleaved(const QString &fileName, SampleType type);
+    QString openSeparate(const QString &keysFileName, const QString &valuesFileName, SampleType type);
+    QString openImplicitKeys(const QString &valuesFileName, SampleType type, double keyOffset, double keyStep);
+    void close();
+
+    bool isOpen() const { return _values; }
+
+    int size() const override { return _size; }
+    double key(int index) const override { return keyAt(index); }
+    double value(int index) const override { return valueAt(index); }
+    int findBegin(double key, bool expandedRange = true) const override;
+    int findEnd(double key, bool expandedRange = true) const override;
+    QCPRange keyRange(bool &foundRange, QCP::SignDomain signDomain) const override;
+    QCPRange valueRange(bool &foundRange, QCP::SignDomain signDomain, int begin, int end) const override;
+    void getLineData(QVector<QCPGraphData> *lineData, int begin, int end, const QCPAxis *keyAxis, bool adaptiveSampling) const override;
+
+private:
+    QScopedPointer<QFile> _keysFile;
+    QScopedPointer<QFile> _valuesFile;
+    const uchar *_keys = nullptr;
+    const uchar *_values = nullptr;
+    SampleType _type = Float64;
+    int _stride = 1; // in samples
+    int _valueShift = 0; // value position in interleaved records
+    bool _implicitKeys = false;
+    double _keyOffset = 0;
+    double _keyStep = 1;
+    int _size = 0;
+
+    double sampleAt(const uchar *data, qint64 index) const
+    {
+        return _type == Float64
+            ? reinterpret_cast<const double*>(data)[index]
+            : double(reinterpret_cast<const float*>(data)[index]);
+    }
+    double keyAt(int index) const
+    {
+        return _implicitKeys ? _keyOffset + index*_keyStep : sampleAt(_keys, qint64(index)*_stride);
+    }
+    double valueAt(int index) const
+    {
+        return sampleAt(_values, qint64(index)*_stride + _valueShift);
+    }
+    int lowerBound(double key) const;
+    int upperBound(double key) const;
+    QString map(QFile *file, const uchar *&data, qint64 &sampleCount);
+    QString setPointCount(qint64 count, const QString &fileName);
+};
+
+} // namespace QCPL
+
+#endif // QCPL_GRAPH_MAPPED_H
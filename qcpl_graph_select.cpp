@@ -115,6 +115,11 @@ bool selectGraphsDlg(Plot *plot)
         .exec();
     if (ok)
     {
+        // Deselection of anything besides graphs has to be repainted on other layers
+        bool onlyGraphsSelected = plot->selectedAxes().isEmpty() &&
+            plot->selectedLegends().isEmpty() && plot->selectedItems().isEmpty() &&
+            plot->selectedPlottables().size() == plot->selectedGraphs().size() &&
+            !plot->title()->selected();
         plot->deselectAll();
         for (int row = 0; row < table->rowCount(); row++)
         {
@@ -122,8 +127,13 @@ bool selectGraphsDlg(Plot *plot)
             if (item->checkState() == Qt::Checked)
                 plot->selectGraph(item->data(Qt::UserRole).value<QCPGraph*>());
         }
-        plot->updateAxesInteractivity();
-        plot->replot();
+        if (onlyGraphsSelected)
+            plot->replotSelection();
+        else
+        {
+            plot->updateAxesInteractivity();
+            plot->replot();
+        }
     }
     return ok;
 }
@@ -0,0 +1,70 @@
+#include "qcpl_parallel.h"
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+namespace QCPL {
+
+namespace {
+
+struct ParallelJob
+{
+    std::function<void(int)> job;
+    int count;
+    QAtomicInt next = 0;
+    QAtomicInt done = 0;
+    QMutex mutex;
+    QWaitCondition finished;
+
+    // Takes indices until there are no more left.
+    // A runnable started after all the indices were taken just exits, nobody waits for it.
+    void process()
+    {
+        int processed = 0;
+        for (int i = next.fetchAndAddRelaxed(1); i < count; i = next.fetchAndAddRelaxed(1))
+        {
+            job(i);
+            processed++;
+        }
+        if (processed > 0 && done.fetchAndAddOrdered(processed) + processed == count)
+        {
+            QMutexLocker locker(&mutex);
+            finished.wakeAll();
+        }
+    }
+};
+
+} // namespace
+
+void runParallel(int count, const std::function<void(int)> &job)
+{
+    if (count <= 0) return;
+
+    auto pool = QThreadPool::globalInstance();
+    const int helperCount = qMin(count, pool->maxThreadCount()) - 1;
+    if (helperCount <= 0)
+    {
+        for (int i = 0; i < count; i++)
+            job(i);
+        return;
+    }
+
+    // The state is shared with runnables because some of them can start after we have returned
+    auto state = QSharedPointer<ParallelJob>::create();
+    state->job = job;
+    state->count = count;
+    for (int i = 0; i < helperCount; i++)
+        pool->start(QRunnable::create([state]{ state->process(); }));
+
+    state->process();
+
+    QMutexLocker locker(&state->mutex);
+    while (state->done.loadAcquire() < count)
+        state->finished.wait(&state->mutex);
+}
+
+} // namespace QCPL
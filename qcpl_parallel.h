@@ -0,0 +1,16 @@
+#ifndef QCPL_PARALLEL_H
+#define QCPL_PARALLEL_H
+
+#include <functional>
+
+namespace QCPL {
+
+/// Calls @a job for every index in [0, @a count) using the global thread pool and returns when all are done.
+/// The calling thread takes part in the work and never waits for pool threads that haven't started yet,
+/// so the function can be safely called from jobs of another runParallel().
+/// Jobs must not touch GUI objects and must not share mutable state without synchronization.
+void runParallel(int count, const std::function<void(int)> &job);
+
+} // namespace QCPL
+
+#endif // QCPL_PARALLEL_H
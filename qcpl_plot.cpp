@@ -7,6 +7,8 @@
 #include "qcpl_graph.h"
 #include "qcpl_format.h"
 #include "qcpl_io_json.h"
+#include "qcpl_parallel.h"
+#include "qcpl_raster.h"
 
 #include "helpers/OriDialogs.h"
 
@@ -43,6 +45,15 @@ inline QFont defaultTitleFont() {
 
 namespace QCPL {
 
+/// Assumed speed of exact geometry calculation in progressive mode until it's measured
+const double defaultPointsPerMs = 50000;
+/// Size of the first progressive draft per pixel of the plot
+const int draftPointsPerPixel = 2;
+/// How much each progressive refinement pass makes drafts more detailed
+const int draftRefineFactor = 8;
+/// Zooming with the wheel is considered finished when the wheel stays still for this time
+const int wheelIdleMs = 200;
+
 Plot::Plot(const PlotOptions& opts, QWidget *parent) : QCustomPlot(parent),
         // TODO: make configurable
         _safeMarginsX(1.0/100.0),
@@ -65,7 +76,8 @@ Plot::Plot(const PlotOptions& opts, QWidget *parent) : QCustomPlot(parent),
 
     if (!LineGraph::sharedSelectionDecorator())
     {
-        // TODO: make selector customizable: line color/width/visibility, points count/color/size/visibility
+        // TODO: make selector customizable: line color/width/visibility, points color/size/visibility
+        // Points count and placement are set via LineGraph::setSelectorHandles()
         auto decorator = new QCPSelectionDecorator;
         decorator->setPen(QPen(QBrush(QColor(0, 240, 255, 120)), 2));
         //decorator->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssSquare, Qt::black, Qt::black, 6));
@@ -73,6 +85,34 @@ Plot::Plot(const PlotOptions& opts, QWidget *parent) : QCustomPlot(parent),
         LineGraph::setSharedSelectionDecorator(decorator);
     }
 
+    // Selection is drawn on its own buffered layer, so selecting a graph doesn't repaint all graphs
+    addLayer(QStringLiteral("selection"), layer(QStringLiteral("main")), limAbove);
+    _selectionLayer = layer(QStringLiteral("selection"));
+    _selectionLayer->setMode(QCPLayer::lmBuffered);
+    new SelectionOverlay(this, _selectionLayer->name());
+
+    _replotTimer = new QTimer(this);
+    _replotTimer->setSingleShot(true);
+    connect(_replotTimer, &QTimer::timeout, this, [this]{ replot(); });
+    // Any replot, even a direct one, satisfies the scheduled one
+    connect(this, &QCustomPlot::afterReplot, this, [this]{
+        _replotTimer->stop();
+        _sinceReplot.start();
+    });
+
+    _refineTimer = new QTimer(this);
+    _refineTimer->setSingleShot(true);
+    connect(_refineTimer, &QTimer::timeout, this, [this]{
+        _refinePass = true;
+        replot();
+        _refinePass = false;
+    });
+
+    _wheelTimer = new QTimer(this);
+    _wheelTimer->setSingleShot(true);
+    connect(_wheelTimer, &QTimer::timeout, this, [this]{ if (!_dragPressed) endInteraction(); });
+    connect(this, &QCustomPlot::afterReplot, this, &Plot::adaptInteractionQuality);
+
     _title = new QCPTextElement(this);
     _title->setMargins({10, 10, 10, 10});
     _title->setSelectable(true);
@@ -134,6 +174,43 @@ void Plot::mouseDoubleClickEvent(QMouseEvent *event)
         emit emptySpaceDoubleClicked(event);
 }
 
+void Plot::mousePressEvent(QMouseEvent *event)
+{
+    // The same button QCPAxisRect::mousePressEvent() starts dragging with
+#ifdef Q_OS_MAC
+    const auto dragButton = Qt::LeftButton;
+#else
+    const auto dragButton = Qt::MiddleButton;
+#endif
+    _dragPressed = (event->buttons() & dragButton) && interactions().testFlag(QCP::iRangeDrag);
+    QCustomPlot::mousePressEvent(event);
+}
+
+void Plot::mouseMoveEvent(QMouseEvent *event)
+{
+    // Before QCPAxisRect moves axes and queues replot
+    if (_dragPressed)
+        beginInteraction();
+    QCustomPlot::mouseMoveEvent(event);
+}
+
+void Plot::mouseReleaseEvent(QMouseEvent *event)
+{
+    QCustomPlot::mouseReleaseEvent(event);
+    _dragPressed = false;
+    endInteraction();
+}
+
+void Plot::wheelEvent(QWheelEvent *event)
+{
+    if (interactions().testFlag(QCP::iRangeZoom))
+    {
+        beginInteraction();
+        _wheelTimer->start(wheelIdleMs);
+    }
+    QCustomPlot::wheelEvent(event);
+}
+
 QMenu* Plot::findContextMenu(const QPointF& pos)
 {
     if (menuTitle && _title->selectTest(pos, false) >= 0)
@@ -183,10 +260,193 @@ void Plot::resizeEvent(QResizeEvent *event)
     emit resized(event->oldSize(), event->size());
 }
 
+void Plot::updateLayout()
+{
+    QCustomPlot::updateLayout();
+
+    // Pixel geometry depends on axis rects which are known only after layout.
+    // Graphs computing it one by one in their draw() would make the replot as slow as all of them together,
+    // so it's prepared for all visible graphs at once and draw() only paints
+    QVector<LineGraph*> graphs;
+    for (auto g : std::as_const(mGraphs))
+        if (auto lg = dynamic_cast<LineGraph*>(g); lg && lg->realVisibility())
+            graphs << lg;
+    // Exports draw the plot outside of replot, graphs make exact geometry for them anyway.
+    // Drafts made for interaction are not touched until it ends
+    if (!_progressive || !mReplotting || _interactionQuality == DraftLines)
+    {
+        runParallel(graphs.size(), [&graphs](int index){ graphs[index]->prepareGeometry(); });
+        return;
+    }
+
+    const qint64 exactPoints = planProgressivePass(graphs);
+    QElapsedTimer timer;
+    timer.start();
+    runParallel(graphs.size(), [&graphs](int index){ graphs[index]->prepareGeometry(); });
+    // Drafts are cheap, the speed of exact calculation is what the budget is checked against
+    const double elapsedMs = timer.nsecsElapsed() / 1e6;
+    if (exactPoints > 0 && elapsedMs >= 1)
+        _pointsPerMs = exactPoints / elapsedMs;
+}
+
+qint64 Plot::planProgressivePass(const QVector<LineGraph*> &graphs)
+{
+    // Any replot besides refinement passes starts over, e.g. a new pan or zoom
+    const bool refining = _refinePass;
+    _refineTimer->stop();
+
+    const double budgetPoints = (_pointsPerMs > 0 ? _pointsPerMs : defaultPointsPerMs) * _progressiveBudget;
+    const int firstDraftPoints = draftPointsPerPixel * qMax(viewport().width(), viewport().height());
+
+    // Graphs already having exact geometry cost nothing, e.g. when only selection or legend has changed
+    QVector<QPair<LineGraph*, int>> pending;
+    double totalPoints = 0;
+    for (auto g : graphs)
+    {
+        if (g->hasExactGeometry())
+        {
+            g->setDraftPoints(0);
+            continue;
+        }
+        const int count = g->visiblePointCount();
+        pending << qMakePair(g, count);
+        totalPoints += count;
+    }
+
+    qint64 exactPoints = 0;
+    bool hasDrafts = false;
+    for (const auto &it : std::as_const(pending))
+    {
+        auto g = it.first;
+        const int count = it.second;
+        int draftPoints = 0;
+        if (refining)
+        {
+            // Drafts get more detailed while they fit the budget, then the exact geometry is made at once
+            const qint64 nextPoints = qint64(g->draftPoints()) * draftRefineFactor;
+            if (g->draftPoints() > 0 && nextPoints <= budgetPoints)
+                draftPoints = int(nextPoints);
+        }
+        else if (totalPoints > budgetPoints)
+            draftPoints = firstDraftPoints;
+        if (draftPoints >= count)
+            draftPoints = 0;
+
+        g->setDraftPoints(draftPoints);
+        if (draftPoints > 0)
+            hasDrafts = true;
+        else
+            exactPoints += count;
+    }
+
+    // Refinement goes after returning to the event loop, so the draft is shown and input is processed
+    if (hasDrafts)
+        _refineTimer->start(0);
+    return exactPoints;
+}
+
+void Plot::setProgressiveRendering(bool on)
+{
+    if (_progressive == on) return;
+    _progressive = on;
+    if (on) return;
+
+    _refineTimer->stop();
+    bool hadDrafts = false;
+    for (auto g : std::as_const(mGraphs))
+        if (auto lg = dynamic_cast<LineGraph*>(g); lg && lg->draftPoints() > 0)
+        {
+            lg->setDraftPoints(0);
+            hadDrafts = true;
+        }
+    if (hadDrafts)
+        scheduleReplot();
+}
+
+void Plot::setProgressiveBudget(int ms)
+{
+    _progressiveBudget = qMax(1, ms);
+}
+
+void Plot::setLowestInteractionQuality(InteractionQuality quality)
+{
+    _lowestInteractionQuality = quality;
+}
+
+void Plot::setInteractionBudget(int ms)
+{
+    _interactionBudget = qMax(1, ms);
+}
+
+void Plot::beginInteraction()
+{
+    if (_interacting || _lowestInteractionQuality == FullQuality)
+        return;
+    _interacting = true;
+    _antialiasedBackup = antialiasedElements();
+    _notAntialiasedBackup = notAntialiasedElements();
+    // No need to refine a progressive draft of the view that is going to change
+    _refineTimer->stop();
+}
+
+void Plot::endInteraction()
+{
+    _wheelTimer->stop();
+    if (!_interacting)
+        return;
+    _interacting = false;
+    if (_interactionQuality == FullQuality)
+        return;
+    applyInteractionQuality(FullQuality);
+    scheduleReplot();
+}
+
+void Plot::adaptInteractionQuality()
+{
+    // The frame just made was too slow, so the next ones are made cheaper.
+    // Quality is never raised back during interaction, switching it back and forth would flicker
+    if (!_interacting || _interactionQuality >= _lowestInteractionQuality)
+        return;
+    if (replotTime() > _interactionBudget)
+        applyInteractionQuality(InteractionQuality(_interactionQuality + 1));
+}
+
+void Plot::applyInteractionQuality(InteractionQuality quality)
+{
+    const InteractionQuality oldQuality = _interactionQuality;
+    _interactionQuality = quality;
+
+    if (quality >= NoAntialiasing)
+        setNotAntialiasedElements(QCP::aeAll);
+    else if (oldQuality >= NoAntialiasing)
+    {
+        setAntialiasedElements(_antialiasedBackup);
+        setNotAntialiasedElements(_notAntialiasedBackup);
+    }
+
+    const int draftPoints = quality >= DraftLines ? draftPointsPerPixel * qMax(viewport().width(), viewport().height()) : 0;
+    for (auto g : std::as_const(mGraphs))
+        if (auto lg = dynamic_cast<LineGraph*>(g); lg)
+        {
+            lg->setLinesOnly(quality >= LinesOnly);
+            if (quality >= DraftLines || oldQuality >= DraftLines)
+                lg->setDraftPoints(draftPoints);
+        }
+}
+
+QCPAbstractPaintBuffer *Plot::createPaintBuffer()
+{
+    if (openGl())
+        return QCustomPlot::createPaintBuffer();
+    // Layers are kept in images so that graphs can draw thin lines right into their pixels
+    return new ImagePaintBuffer(viewport().size(), mBufferDevicePixelRatio);
+}
+
 void Plot::plotSelectionChanged()
 {
     auto allAxes = axisRect()->axes();
     int countX = 0, countY = 0;
+    QSet<Axis*> oldHighlight, newHighlight;
     QList<QCPAxis*> axesX, axesY;
     for (auto axis : std::as_const(allAxes))
     {
@@ -198,7 +458,10 @@ void Plot::plotSelectionChanged()
 
         if (highlightAxesOfSelectedGraphs)
             if (auto a = dynamic_cast<Axis*>(axis); a)
+            {
+                if (a->hightlight()) oldHighlight << a;
                 a->setHightlight(false);
+            }
 
         if (axis->selectedParts().testFlag(QCPAxis::spAxis) ||
             axis->selectedParts().testFlag(QCPAxis::spTickLabels))
@@ -236,9 +499,15 @@ void Plot::plotSelectionChanged()
         if (highlightAxesOfSelectedGraphs && (countX > 1 || countY > 1))
         {
             if (auto a = dynamic_cast<Axis*>(x); a)
+            {
                 a->setHightlight(true);
+                newHighlight << a;
+            }
             if (auto a = dynamic_cast<Axis*>(y); a)
+            {
                 a->setHightlight(true);
+                newHighlight << a;
+            }
         }
     }
     
@@ -254,6 +523,87 @@ void Plot::plotSelectionChanged()
     }
     axisRect()->setRangeDragAxes(axesX, axesY);
     axisRect()->setRangeZoomAxes(axesX, axesY);
+    _axesHighlightChanged = oldHighlight != newHighlight;
+}
+
+void Plot::processPointSelection(QMouseEvent *event)
+{
+    // This is QCustomPlot::processPointSelection() except it doesn't replot the whole plot
+    // when only selection of graphs drawing their selection on the selection layer has changed
+    QVariant details;
+    QCPLayerable *clickedLayerable = layerableAt(event->pos(), true, &details);
+    bool selectionStateChanged = false;
+    bool onlyGraphsChanged = true;
+    auto trackChange = [&](QCPLayerable *layerable, bool selChanged) {
+        if (!selChanged) return;
+        selectionStateChanged = true;
+        auto g = dynamic_cast<LineGraph*>(layerable);
+        if (!g || !g->selectionOnOverlay())
+            onlyGraphsChanged = false;
+    };
+    bool additive = mInteractions.testFlag(QCP::iMultiSelect) && event->modifiers().testFlag(mMultiSelectModifier);
+    // deselect all other layerables if not additive selection
+    if (!additive)
+    {
+        for (auto layer : std::as_const(mLayers))
+        {
+            const auto children = layer->children();
+            for (auto layerable : children)
+            {
+                if (layerable != clickedLayerable && mInteractions.testFlag(layerable->selectionCategory()))
+                {
+                    bool selChanged = false;
+                    layerable->deselectEvent(&selChanged);
+                    trackChange(layerable, selChanged);
+                }
+            }
+        }
+    }
+    if (clickedLayerable && mInteractions.testFlag(clickedLayerable->selectionCategory()))
+    {
+        bool selChanged = false;
+        clickedLayerable->selectEvent(event, additive, details, &selChanged);
+        trackChange(clickedLayerable, selChanged);
+    }
+    if (selectionStateChanged)
+    {
+        // Axes highlighting is updated by plotSelectionChanged() connected to this signal
+        emit selectionChangedByUser();
+        if (onlyGraphsChanged && !_axesHighlightChanged)
+            _selectionLayer->replot();
+        else
+            scheduleReplot();
+    }
+}
+
+void Plot::scheduleReplot()
+{
+    if (_replotTimer->isActive())
+        return;
+    int delay = 0;
+    if (_maxFps > 0 && _sinceReplot.isValid())
+        delay = qMax(0, int(1000 / _maxFps - _sinceReplot.elapsed()));
+    _replotTimer->start(delay);
+}
+
+void Plot::flushReplot()
+{
+    if (_replotTimer->isActive())
+        replot();
+}
+
+void Plot::setMaxFps(int fps)
+{
+    _maxFps = qMax(0, fps);
+}
+
+void Plot::replotSelection()
+{
+    plotSelectionChanged();
+    if (_axesHighlightChanged)
+        scheduleReplot();
+    else
+        _selectionLayer->replot();
 }
 
 void Plot::rawGraphClicked(QCPAbstractPlottable *plottable)
@@ -292,9 +642,6 @@ QSet<QPair<QCPAxis*, QCPAxis*>> Plot::getActiveAxisPairs() const
             
         if (!g->visible()) continue;
 
-        if (g->property(PROP_GRAPH_IS_CURSOR).toBool())
-            continue;
-                
         if (selectedAxes.contains(x) || selectedAxes.contains(y))
             pairs.insert({x, y});
     }
@@ -304,109 +651,146 @@ QSet<QPair<QCPAxis*, QCPAxis*>> Plot::getActiveAxisPairs() const
 
 void Plot::autolimits(QCPAxis* axis, bool replot)
 {
-    QCPRange totalRange;
-    bool isTotalValid = false;
-    bool isX = axis->orientation() == Qt::Horizontal;
+    autolimits(QVector<QCPAxis*>{axis}, replot);
+}
+
+void Plot::autolimits(const QVector<QCPAxis*> &axes, bool replot, bool inVisibleKeys)
+{
+    struct RangeJob
+    {
+        Graph *graph;
+        QCPAxis *keyAxis = nullptr;
+        QCPAxis *valueAxis = nullptr;
+        QCP::SignDomain keySignDomain = QCP::sdBoth;
+        QCP::SignDomain valueSignDomain = QCP::sdBoth;
+        QCPRange valueKeyRange; // empty range means all keys
+        QCPRange keyRange;
+        QCPRange valueRange;
+        bool hasKeyRange = false;
+        bool hasValueRange = false;
+    };
+
+    // Non-positive values can't be shown on log axes and would break the range
+    auto signDomain = [](QCPAxis *axis) {
+        return axis->scaleType() == QCPAxis::stLogarithmic ? QCP::sdPositive : QCP::sdBoth;
+    };
+
+    // Group graphs by axes in one pass, horizontal axes are limited by keys and vertical ones by values
+    QSet<QCPAxis*> targetAxes(axes.cbegin(), axes.cend());
+    QVector<RangeJob> jobs;
     for (auto g : std::as_const(mGraphs))
     {
         if (!g->visible()) continue;
-        
-        if (g->property(PROP_GRAPH_IS_CURSOR).toBool())
-            continue;
-
-        if (isX) {
-            if (g->keyAxis() != axis) continue;
-        } else if (g->valueAxis() != axis) continue;
 
-        bool hasRange = false;
-        auto range = isX
-                ? g->getKeyRange(hasRange, QCP::sdBoth)
-                : g->getValueRange(hasRange, QCP::sdBoth, QCPRange());
-        if (!hasRange) continue;
-
-        if (!isTotalValid)
+        RangeJob job { g };
+        auto x = g->keyAxis();
+        auto y = g->valueAxis();
+        if (x->orientation() == Qt::Horizontal && targetAxes.contains(x))
         {
-            totalRange = range;
-            isTotalValid = true;
+            job.keyAxis = x;
+            job.keySignDomain = signDomain(x);
         }
-        else totalRange.expand(range);
+        if (y->orientation() == Qt::Vertical && targetAxes.contains(y))
+        {
+            job.valueAxis = y;
+            job.valueSignDomain = signDomain(y);
+            if (inVisibleKeys)
+                job.valueKeyRange = x->range();
+        }
+        if (job.keyAxis || job.valueAxis)
+            jobs << job;
+    }
+
+    // Each job touches only its own graph, LineGraph caches its bounds and splits large data into chunks itself
+    runParallel(jobs.size(), [&jobs](int index){
+        auto &job = jobs[index];
+        if (job.keyAxis)
+            job.keyRange = job.graph->getKeyRange(job.hasKeyRange, job.keySignDomain);
+        if (job.valueAxis)
+            job.valueRange = job.graph->getValueRange(job.hasValueRange, job.valueSignDomain, job.valueKeyRange);
+    });
+
+    QHash<QCPAxis*, QCPRange> totalRanges;
+    auto mergeRange = [&totalRanges](QCPAxis *axis, const QCPRange &range) {
+        auto it = totalRanges.find(axis);
+        if (it == totalRanges.end())
+            totalRanges.insert(axis, range);
+        else it->expand(range);
+    };
+    for (const auto &job : std::as_const(jobs))
+    {
+        if (job.hasKeyRange) mergeRange(job.keyAxis, job.keyRange);
+        if (job.hasValueRange) mergeRange(job.valueAxis, job.valueRange);
     }
 
-    if (!isTotalValid) return;
+    for (auto axis : axes)
+    {
+        auto it = totalRanges.find(axis);
+        if (it == totalRanges.end()) continue;
+
+        QCPRange totalRange = it.value();
+        // An axis can be mentioned several times, it should be extended only once
+        totalRanges.erase(it);
 
-    bool corrected = correctZeroRange(totalRange, safeMargins(axis));
-    axis->setRange(totalRange);
+        bool corrected = correctZeroRange(totalRange, safeMargins(axis));
+        axis->setRange(totalRange);
 
-    if (!corrected && useSafeMargins)
-        extendLimits(axis, safeMargins(axis), false);
+        if (!corrected && useSafeMargins)
+            extendLimits(axis, safeMargins(axis), false);
+    }
 
-    if (replot) this->replot();
+    if (replot) scheduleReplot();
 }
 
 void Plot::autolimits(bool replot)
 {
     if (autolimitOnlyPrimaryAxes)
     {
-        autolimits(xAxis, false);
-        autolimits(yAxis, replot);
+        autolimits({xAxis, yAxis}, replot);
         return;
     }
+    QVector<QCPAxis*> axes;
     if (auto pairs = getActiveAxisPairs(); !pairs.isEmpty())
     {
         for (const auto &pair : std::as_const(pairs))
-        {
-            autolimits(pair.first, false);
-            autolimits(pair.second, false);
-        }
+            axes << pair.first << pair.second;
     }
-    else
-    {
-        for (auto axis : axisRect()->axes())
-            autolimits(axis, false);
-    }
-    if (replot) this->replot();
+    else axes = axisRect()->axes().toVector();
+    autolimits(axes, replot);
 }
 
-void Plot::autolimitsX(bool replot)
+QVector<QCPAxis*> Plot::autolimitAxes(Qt::Orientation orientation) const
 {
     if (autolimitOnlyPrimaryAxes)
-    {
-        autolimits(xAxis, replot);
-        return;
-    }
+        return { orientation == Qt::Horizontal ? xAxis : yAxis };
+    QVector<QCPAxis*> axes;
     if (auto pairs = getActiveAxisPairs(); !pairs.isEmpty())
     {
         for (const auto &pair : std::as_const(pairs))
-            autolimits(pair.first, false);
+            axes << (orientation == Qt::Horizontal ? pair.first : pair.second);
     }
     else
     {
         for (auto axis : axisRect()->axes())
-            if (axis->orientation() == Qt::Horizontal)
-                autolimits(axis, false);
+            if (axis->orientation() == orientation)
+                axes << axis;
     }
-    if (replot) this->replot();
+    return axes;
+}
+
+void Plot::autolimitsX(bool replot)
+{
+    autolimits(autolimitAxes(Qt::Horizontal), replot);
 }
 
 void Plot::autolimitsY(bool replot)
 {
-    if (autolimitOnlyPrimaryAxes)
-    {
-        autolimits(yAxis, replot);
-        return;
-    }
-    if (auto pairs = getActiveAxisPairs(); !pairs.isEmpty())
-    {
-        for (const auto &pair : std::as_const(pairs))
-            autolimits(pair.second, false);
-    }
-    else
-    {
-        for (auto axis : axisRect()->axes())
-            if (axis->orientation() == Qt::Vertical)
-                autolimits(axis, false);
-    }
-    if (replot) this->replot();
+    autolimits(autolimitAxes(Qt::Vertical), replot);
+}
+
+void Plot::autolimitsYInVisibleX(bool replot)
+{
+    autolimits(autolimitAxes(Qt::Vertical), replot, true);
 }
 
 void Plot::extendLimits(QCPAxis* axis, double factor, bool replot)
@@ -416,7 +800,7 @@ void Plot::extendLimits(QCPAxis* axis, double factor, bool replot)
     range.upper += delta;
     range.lower -= delta;
     setAxisRange(axis, range);
-    if (replot) this->replot();
+    if (replot) scheduleReplot();
 }
 
 void Plot::extendLimits(double factor, bool replot)
@@ -440,7 +824,7 @@ void Plot::extendLimits(double factor, bool replot)
         for (auto axis : axisRect()->axes())
             extendLimits(axis, factor, false);
     }
-    if (replot) this->replot();
+    if (replot) scheduleReplot();
 }
 
 void Plot::extendLimitsX(double factor, bool replot)
@@ -461,7 +845,7 @@ void Plot::extendLimitsX(double factor, bool replot)
             if (axis->orientation() == Qt::Horizontal)
                 extendLimits(axis, factor, false);
     }
-    if (replot) this->replot();
+    if (replot) scheduleReplot();
 }
 
 void Plot::extendLimitsY(double factor, bool replot)
@@ -482,7 +866,7 @@ void Plot::extendLimitsY(double factor, bool replot)
             if (axis->orientation() == Qt::Vertical)
                 extendLimits(axis, factor, false);
     }
-    if (replot) this->replot();
+    if (replot) scheduleReplot();
 }
 
 void Plot::setLimits(QCPAxis* axis, double min, double max, bool replot)
@@ -490,7 +874,7 @@ void Plot::setLimits(QCPAxis* axis, double min, double max, bool replot)
     QCPRange range(min, max);
     range.normalize();
     setAxisRange(axis, range);
-    if (replot) this->replot();
+    if (replot) scheduleReplot();
 }
 
 AxisLimits Plot::limits(QCPAxis* axis) const
@@ -521,7 +905,7 @@ bool Plot::limitsDlg(QCPAxis* axis)
     if (axisLimitsDlg(range, props))
     {
         setAxisRange(axis, range);
-        replot();
+        scheduleReplot();
         return true;
     }
     return false;
@@ -705,6 +1089,7 @@ QString Plot::axisIdent(QCPAxis* axis) const
 Graph* Plot::makeNewGraph(const QString& title)
 {
     auto g = new LineGraph(xAxis, yAxis);
+    g->setSelectionOnOverlay(true);
 
     if (graphAutoColors)
         g->setPen(nextGraphColor());
@@ -718,14 +1103,157 @@ Graph* Plot::makeNewGraph(const QString &title, const GraphData &data, bool repl
 {
     auto g = makeNewGraph(title);
     g->setData(data.x, data.y);
-    if (replot) this->replot();
+    if (replot) scheduleReplot();
     return g;
 }
 
 void Plot::updateGraph(Graph* graph, const GraphData &data, bool replot)
 {
-    graph->setData(data.x, data.y);
-    if (replot) this->replot();
+    if (auto g = dynamic_cast<LineGraph*>(graph); g)
+        g->setData(data.x, data.y);
+    else
+        graph->setData(data.x, data.y);
+    if (replot) scheduleReplot();
+}
+
+Graph* Plot::makeNewGraph(const QString &title, GraphData &&data, bool replot)
+{
+    return makeNewGraph(title, makeGraphData(std::move(data)), replot);
+}
+
+Graph* Plot::makeNewGraph(const QString &title, const QSharedPointer<QCPGraphDataContainer> &data, bool replot)
+{
+    auto g = static_cast<LineGraph*>(makeNewGraph(title));
+    g->setData(data);
+    if (replot) scheduleReplot();
+    return g;
+}
+
+void Plot::updateGraph(Graph* graph, GraphData &&data, bool replot)
+{
+    updateGraph(graph, makeGraphData(std::move(data)), replot);
+}
+
+void Plot::updateGraph(Graph* graph, const QSharedPointer<QCPGraphDataContainer> &data, bool replot)
+{
+    // QCPGraph::setData() is not virtual, LineGraph's one also drops its data caches
+    if (auto g = dynamic_cast<LineGraph*>(graph); g)
+        g->setData(data);
+    else
+        graph->setData(data);
+    if (replot) scheduleReplot();
+}
+
+Graph* Plot::makeNewGraph(const QString &title, const QSharedPointer<GraphDataSource> &data, bool replot)
+{
+    auto g = static_cast<LineGraph*>(makeNewGraph(title));
+    g->setDataSource(data);
+    if (replot) scheduleReplot();
+    return g;
+}
+
+void Plot::updateGraph(Graph* graph, const QSharedPointer<GraphDataSource> &data, bool replot)
+{
+    if (auto g = dynamic_cast<LineGraph*>(graph); g)
+        g->setDataSource(data);
+    else
+        qWarning() << Q_FUNC_INFO << "graph doesn't support external data source";
+    if (replot) scheduleReplot();
+}
+
+void Plot::appendToGraph(Graph* graph, const ValueArray &keys, const ValueArray &values, bool replot)
+{
+    if (auto g = dynamic_cast<LineGraph*>(graph); g)
+        g->appendData(keys, values);
+    else
+        graph->addData(keys, values, true);
+    if (replot) scheduleReplot();
+}
+
+QVector<Graph*> Plot::makeNewGraphs(const QStringList &titles)
+{
+    QVector<Graph*> graphs;
+    graphs.reserve(titles.size());
+
+    // Adding legend items one by one is O(n) each because the legend searches for a free cell every time
+    const bool autoAddToLegend = autoAddPlottableToLegend();
+    const bool addToLegend = autoAddToLegend && legend;
+    setAutoAddPlottableToLegend(false);
+    for (const auto &title : titles)
+        graphs << makeNewGraph(title);
+    setAutoAddPlottableToLegend(autoAddToLegend);
+
+    if (addToLegend && !graphs.isEmpty())
+    {
+        for (auto g : std::as_const(graphs))
+            legend->addElement(legend->rowCount(), 0, new QCPPlottableLegendItem(legend, g));
+        // Rearranges all items according to the legend fill order and wrapping at once
+        legend->setFillOrder(legend->fillOrder(), true);
+    }
+    return graphs;
+}
+
+QVector<Graph*> Plot::makeNewGraphs(const QVector<QPair<QString, GraphData>> &graphs, bool replot)
+{
+    QStringList titles;
+    titles.reserve(graphs.size());
+    for (const auto &g : graphs)
+        titles << g.first;
+    auto newGraphs = makeNewGraphs(titles);
+    for (int i = 0; i < newGraphs.size(); i++)
+        newGraphs.at(i)->setData(graphs.at(i).second.x, graphs.at(i).second.y);
+    if (replot) scheduleReplot();
+    return newGraphs;
+}
+
+void Plot::removeGraphs(const QVector<Graph*> &graphs, bool replot)
+{
+    QSet<QCPAbstractPlottable*> removing;
+    {
+        QSet<QCPAbstractPlottable*> existing(mGraphs.cbegin(), mGraphs.cend());
+        for (auto g : graphs)
+            if (existing.contains(g))
+                removing.insert(g);
+    }
+    if (removing.isEmpty()) return;
+
+    // Every deleted layerable removes itself from its layer by a linear search,
+    // so they are detached from the layers in one pass before deleting
+    QSet<QCPLayerable*> detaching(removing.cbegin(), removing.cend());
+
+    // QCustomPlot::removeGraph() rearranges the legend after each removed item,
+    // here items are taken out in one pass and rearranged once
+    QVector<QCPLayoutElement*> legendItems;
+    if (legend)
+    {
+        for (int i = legend->elementCount()-1; i >= 0; i--)
+            if (auto item = qobject_cast<QCPPlottableLegendItem*>(legend->elementAt(i)); item && removing.contains(item->plottable()))
+            {
+                legendItems << legend->takeAt(i);
+                detaching.insert(item);
+            }
+        legend->setFillOrder(legend->fillOrder(), true);
+    }
+
+    mGraphs.erase(std::remove_if(mGraphs.begin(), mGraphs.end(),
+        [&removing](QCPGraph *g){ return removing.contains(g); }), mGraphs.end());
+    mPlottables.erase(std::remove_if(mPlottables.begin(), mPlottables.end(),
+        [&removing](QCPAbstractPlottable *p){ return removing.contains(p); }), mPlottables.end());
+
+    detachFromLayers(detaching);
+    qDeleteAll(legendItems);
+    qDeleteAll(removing);
+
+    if (replot) scheduleReplot();
+}
+
+void Plot::clearUserGraphs(bool replot)
+{
+    QVector<Graph*> graphs;
+    for (auto g : std::as_const(mGraphs))
+        if (!g->property(PROP_GRAPH_DONT_COUNT).toBool())
+            graphs << g;
+    removeGraphs(graphs, replot);
 }
 
 QColor Plot::nextGraphColor()
@@ -743,7 +1271,7 @@ Graph* Plot::selectedGraph() const
 
 void Plot::selectGraph(Graph *graph)
 {
-    graph->setSelection(QCPDataSelection(graph->data()->dataRange()));
+    graph->setSelection(QCPDataSelection(QCPDataRange(0, graph->dataCount())));
 }
 
 void Plot::copyPlotImage()
@@ -884,7 +1412,7 @@ void Plot::setAxisFactor(QCPAxis* axis, const AxisFactor& factor)
     }
     if (formatAxisTitleAfterFactorSet)
         updateText(axis);
-    replot();
+    scheduleReplot();
 }
 
 void Plot::initDefault(QCPAxis* axis)
@@ -935,4 +1463,11 @@ QCPAxis* Plot::findAxisById(const QString &id)
     return nullptr;
 }
 
+void scheduleReplot(QCustomPlot *plot)
+{
+    if (auto p = qobject_cast<Plot*>(plot); p)
+        p->scheduleReplot();
+    else plot->replot(QCustomPlot::rpQueuedReplot);
+}
+
 } // namespace QCPL
@@ -4,12 +4,16 @@
 #include "qcpl_types.h"
 #include "qcustomplot/qcustomplot.h"
 
+#include <QElapsedTimer>
+
 namespace QCPL {
 
 typedef QCPGraph Graph;
 
 class TextFormatterBase;
 class FormatSaver;
+class GraphDataSource;
+class LineGraph;
 
 struct LayoutCell
 {
@@ -79,6 +83,32 @@ public:
     Graph* makeNewGraph(const QString &title, const GraphData &data, bool replot = true);
     void updateGraph(Graph* graph, const GraphData &data, bool replot = true);
 
+    /// These overloads take ownership on the data and pass it to the graph without extra copies.
+    /// The moved data is released as soon as it's converted into the graph's point container.
+    /// A prepared container (see makeGraphData()) is set as is, without copying or sorting.
+    Graph* makeNewGraph(const QString &title, GraphData &&data, bool replot = true);
+    Graph* makeNewGraph(const QString &title, const QSharedPointer<QCPGraphDataContainer> &data, bool replot = true);
+    void updateGraph(Graph* graph, GraphData &&data, bool replot = true);
+    void updateGraph(Graph* graph, const QSharedPointer<QCPGraphDataContainer> &data, bool replot = true);
+
+    /// These overloads make the graph to draw points right from the given storage
+    /// (e.g. ColumnarGraphData) instead of its own data container, see LineGraph::setDataSource().
+    Graph* makeNewGraph(const QString &title, const QSharedPointer<GraphDataSource> &data, bool replot = true);
+    void updateGraph(Graph* graph, const QSharedPointer<GraphDataSource> &data, bool replot = true);
+
+    /// Batch versions of makeNewGraph() and removeGraph().
+    /// They update the graph lists and the legend once for all the graphs and replot only once.
+    QVector<Graph*> makeNewGraphs(const QStringList &titles);
+    QVector<Graph*> makeNewGraphs(const QVector<QPair<QString, GraphData>> &graphs, bool replot = true);
+    void removeGraphs(const QVector<Graph*> &graphs, bool replot = true);
+
+    /// Removes all graphs counted by userGraphsCount(), graphs marked with PROP_GRAPH_DONT_COUNT are kept.
+    void clearUserGraphs(bool replot = true);
+
+    /// Appends new points to the graph in streaming mode, see LineGraph::appendData().
+    /// The history length of the graph can be bounded with LineGraph::setMaxPointCount().
+    void appendToGraph(Graph* graph, const ValueArray &keys, const ValueArray &values, bool replot = true);
+
     /// Returns plot title. The plot has one predefined default title object.
     QCPTextElement* title() { return _title; }
 
@@ -91,6 +121,59 @@ public:
     
     void updateAxesInteractivity();
 
+    /// Marks the plot as changed. It's replotted on the next frame but not more often than maxFps() times per second,
+    /// so a burst of changes results in a single replot. Plot methods having the `replot` argument use this too.
+    void scheduleReplot();
+
+    /// Makes the scheduled replot immediately, e.g. when an up-to-date widget image is needed.
+    void flushReplot();
+
+    bool isReplotScheduled() const { return _replotTimer->isActive(); }
+
+    /// Limits the rate of scheduled replots, zero means replotting on every event loop iteration.
+    int maxFps() const { return _maxFps; }
+    void setMaxFps(int fps);
+
+    /// Applies changed graph selection to axes interactivity and repaints only the selection layer,
+    /// graphs made by the plot draw their selection there. When axes highlighting has changed too,
+    /// the whole plot is replotted. Use it after selecting graphs with selectGraph().
+    void replotSelection();
+
+    /// When enabled, a replot that is estimated to take longer than progressiveBudget() draws large graphs
+    /// as a coarse approximation first (see LineGraph::setDraftPoints()), and then they are refined by
+    /// several replots made from the event loop until they match the exact render.
+    /// Any other replot, e.g. caused by a new pan or zoom, cancels the pending refinement and starts over.
+    bool progressiveRendering() const { return _progressive; }
+    void setProgressiveRendering(bool on);
+
+    /// Time budget of a replot in progressive mode, in milliseconds.
+    int progressiveBudget() const { return _progressiveBudget; }
+    void setProgressiveBudget(int ms);
+
+    bool isRefinementPending() const { return _refineTimer->isActive(); }
+
+    /// Steps of lowering render quality while the user pans or zooms, each one includes the previous ones.
+    enum InteractionQuality
+    {
+        FullQuality,    ///< Nothing is changed
+        NoAntialiasing, ///< Nothing is antialiased
+        LinesOnly,      ///< Graphs don't draw scatters, see LineGraph::setLinesOnly()
+        DraftLines,     ///< Graphs draw a coarse draft of lines, see LineGraph::setDraftPoints()
+    };
+
+    /// While the user drags axes or zooms with the wheel, each replot taking longer than interactionBudget()
+    /// makes next frames one step cheaper, down to this quality. When the interaction ends,
+    /// the plot is replotted once at full quality. FullQuality disables the adaptation, it's the default.
+    InteractionQuality lowestInteractionQuality() const { return _lowestInteractionQuality; }
+    void setLowestInteractionQuality(InteractionQuality quality);
+
+    /// Replot time during interaction, in milliseconds, exceeding which lowers the quality.
+    int interactionBudget() const { return _interactionBudget; }
+    void setInteractionBudget(int ms);
+
+    /// Quality of the current frames, it's lower than FullQuality only during interaction.
+    InteractionQuality interactionQuality() const { return _interactionQuality; }
+
     AxisLimits limitsX() const { return limits(xAxis); }
     AxisLimits limitsY() const { return limits(yAxis); }
     AxisLimits limits(QCPAxis* axis) const;
@@ -163,6 +246,12 @@ public:
     bool colorScaleFormatDlg(QCPColorScale* axis);
     void autolimits(QCPAxis* axis, bool replot);
 
+    /// Fits the given axes to their graphs at once.
+    /// Graphs are grouped by axes in one pass and their ranges are calculated in parallel.
+    /// When @a inVisibleKeys is true, vertical axes are fitted only to the points
+    /// lying within the current ranges of key axes of their graphs.
+    void autolimits(const QVector<QCPAxis*> &axes, bool replot, bool inVisibleKeys = false);
+
     QString axisIdent(QCPAxis* axis) const;
     QCPAxis* addAxis(QCPAxis::AxisType axisType);
     QCPAxis* selectedAxis() const;
@@ -173,6 +262,7 @@ public slots:
     void autolimits(bool replot = true);
     void autolimitsX(bool replot = true);
     void autolimitsY(bool replot = true);
+    void autolimitsYInVisibleX(bool replot = true);
     bool limitsDlgX();
     bool limitsDlgY();
     //bool limitsDlgXY();
@@ -202,7 +292,14 @@ signals:
 protected:
     void contextMenuEvent(QContextMenuEvent *event) override;
     void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
     void resizeEvent(QResizeEvent *event) override;
+    void updateLayout() override;
+    void processPointSelection(QMouseEvent *event) override;
+    QCPAbstractPaintBuffer *createPaintBuffer() override;
     
 private slots:
     void plotSelectionChanged();
@@ -221,6 +318,24 @@ private:
     QMap<void*, TextFormatterBase*> _formatters;
     QMap<void*, QString> _defaultTexts;
     QCPLayoutGrid *_backupLayout;
+    QCPLayer *_selectionLayer;
+    QTimer *_replotTimer;
+    QElapsedTimer _sinceReplot;
+    int _maxFps = 60;
+    QTimer *_refineTimer;
+    bool _progressive = false;
+    bool _refinePass = false;
+    int _progressiveBudget = 16;
+    double _pointsPerMs = 0;
+    QTimer *_wheelTimer;
+    InteractionQuality _lowestInteractionQuality = FullQuality;
+    InteractionQuality _interactionQuality = FullQuality;
+    int _interactionBudget = 16;
+    bool _interacting = false;
+    bool _dragPressed = false;
+    QCP::AntialiasedElements _antialiasedBackup;
+    QCP::AntialiasedElements _notAntialiasedBackup;
+    bool _axesHighlightChanged = false;
 
     QColor nextGraphColor();
 
@@ -230,8 +345,17 @@ private:
     QMenu* findContextMenu(const QPointF& pos);
     QString axisTypeStr(QCPAxis::AxisType type) const;
     QSet<QPair<QCPAxis*, QCPAxis*>> getActiveAxisPairs() const;
+    QVector<QCPAxis*> autolimitAxes(Qt::Orientation orientation) const;
+    qint64 planProgressivePass(const QVector<LineGraph*> &graphs);
+    void beginInteraction();
+    void endInteraction();
+    void adaptInteractionQuality();
+    void applyInteractionQuality(InteractionQuality quality);
 };
 
+/// Calls Plot::scheduleReplot() if @a plot is QCPL::Plot, or queues replot otherwise.
+void scheduleReplot(QCustomPlot *plot);
+
 } // namespace QCPL
 
 #endif // QCPL_PLOT_H
@@ -0,0 +1,414 @@
+#include "qcpl_raster.h"
+
+#include <QApplication>
+#include <QDataStream>
+#include <QPixmapCache>
+#include <QThread>
+
+#include <cmath>
+
+namespace QCPL {
+
+//------------------------------------------------------------------------------
+//                              ImagePaintBuffer
+//------------------------------------------------------------------------------
+
+ImagePaintBuffer::ImagePaintBuffer(const QSize &size, double devicePixelRatio) : QCPAbstractPaintBuffer(size, devicePixelRatio)
+{
+    ImagePaintBuffer::reallocateBuffer();
+}
+
+QCPPainter *ImagePaintBuffer::startPainting()
+{
+    // The same as QCPPaintBufferPixmap does
+    QCPPainter *result = new QCPPainter(&_buffer);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+  #if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    result->setRenderHint(QPainter::Antialiasing);
+  #else
+    result->setRenderHint(QPainter::HighQualityAntialiasing);
+  #endif
+#endif
+    return result;
+}
+
+void ImagePaintBuffer::draw(QCPPainter *painter) const
+{
+    if (painter && painter->isActive())
+        painter->drawImage(0, 0, _buffer);
+    else
+        qDebug() << Q_FUNC_INFO << "invalid or inactive painter passed";
+}
+
+void ImagePaintBuffer::clear(const QColor &color)
+{
+    _buffer.fill(color);
+}
+
+void ImagePaintBuffer::reallocateBuffer()
+{
+    setInvalidated();
+    _buffer = QImage(mSize*mDevicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+    _buffer.setDevicePixelRatio(mDevicePixelRatio);
+}
+
+//------------------------------------------------------------------------------
+//                              drawThinPolyline
+//------------------------------------------------------------------------------
+
+namespace {
+
+/// Multiplies all channels of premultiplied ARGB color by @a a/255
+inline quint32 byteMul(quint32 x, quint32 a)
+{
+    quint32 t = (x & 0xff00ff) * a;
+    t = (t + ((t >> 8) & 0xff00ff) + 0x800080) >> 8;
+    t &= 0xff00ff;
+    x = ((x >> 8) & 0xff00ff) * a;
+    x = (x + ((x >> 8) & 0xff00ff) + 0x800080);
+    x &= 0xff00ff00;
+    return x | t;
+}
+
+class PixelWriter
+{
+public:
+    PixelWriter(QImage *image, const QRect &clip, QRgb color) :
+        _bits(image->bits()), _bytesPerLine(image->bytesPerLine()), _clip(clip),
+        _color(qPremultiply(color)), _opaque(qAlpha(color) == 255) {}
+
+    void plot(int x, int y)
+    {
+        if (!_clip.contains(x, y)) return;
+        quint32 &dst = pixel(x, y);
+        if (_opaque)
+            dst = _color;
+        else
+            dst = _color + byteMul(dst, 255 - qAlpha(_color));
+    }
+
+    void blend(int x, int y, double coverage)
+    {
+        if (!_clip.contains(x, y)) return;
+        const quint32 c = quint32(coverage*255 + 0.5);
+        if (c == 0) return;
+        const quint32 src = c >= 255 ? _color : byteMul(_color, c);
+        quint32 &dst = pixel(x, y);
+        dst = src + byteMul(dst, 255 - qAlpha(src));
+    }
+
+private:
+    uchar *_bits;
+    qsizetype _bytesPerLine;
+    QRect _clip;
+    quint32 _color;
+    bool _opaque;
+
+    quint32& pixel(int x, int y) { return reinterpret_cast<quint32*>(_bits + y*_bytesPerLine)[x]; }
+};
+
+/// Liang-Barsky clipping, returns false if the segment is entirely outside of the rect.
+/// Zoomed in data can give coordinates far beyond the image, they must not be walked pixel by pixel.
+bool clipSegment(QPointF &a, QPointF &b, const QRectF &rect)
+{
+    double t0 = 0, t1 = 1;
+    const double dx = b.x() - a.x();
+    const double dy = b.y() - a.y();
+    auto clip = [&t0, &t1](double p, double q) {
+        if (p == 0) return q >= 0;
+        const double t = q / p;
+        if (p < 0)
+        {
+            if (t > t1) return false;
+            if (t > t0) t0 = t;
+        }
+        else
+        {
+            if (t < t0) return false;
+            if (t < t1) t1 = t;
+        }
+        return true;
+    };
+    if (!clip(-dx, a.x() - rect.left()) || !clip(dx, rect.right() - a.x()) ||
+        !clip(-dy, a.y() - rect.top()) || !clip(dy, rect.bottom() - a.y()))
+        return false;
+    const QPointF start = a;
+    if (t1 < 1) b = QPointF(start.x() + t1*dx, start.y() + t1*dy);
+    if (t0 > 0) a = QPointF(start.x() + t0*dx, start.y() + t0*dy);
+    return true;
+}
+
+/// Bresenham line, the last pixel is skipped unless @a lastPixel is set
+/// so that joints of polyline segments are not painted twice.
+void drawAliasedSegment(PixelWriter &writer, const QPointF &a, const QPointF &b, bool lastPixel)
+{
+    int x0 = int(std::floor(a.x())), y0 = int(std::floor(a.y()));
+    const int x1 = int(std::floor(b.x())), y1 = int(std::floor(b.y()));
+    const int dx = qAbs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    const int dy = -qAbs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    while (x0 != x1 || y0 != y1)
+    {
+        writer.plot(x0, y0);
+        const int e2 = 2*err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+    if (lastPixel)
+        writer.plot(x0, y0);
+}
+
+/// Xiaolin Wu's line. Pixel centers are at half-integer coordinates as in QPainter.
+void drawAntialiasedSegment(PixelWriter &writer, const QPointF &a, const QPointF &b, bool lastPixel)
+{
+    double x0 = a.x() - 0.5, y0 = a.y() - 0.5;
+    double x1 = b.x() - 0.5, y1 = b.y() - 0.5;
+    const bool steep = qAbs(y1 - y0) > qAbs(x1 - x0);
+    if (steep)
+    {
+        std::swap(x0, y0);
+        std::swap(x1, y1);
+    }
+    bool drawStart = true, drawEnd = lastPixel;
+    if (x0 > x1)
+    {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+        std::swap(drawStart, drawEnd);
+    }
+    auto plot = [&writer, steep](int x, int y, double coverage) {
+        if (steep)
+            writer.blend(y, x, coverage);
+        else
+            writer.blend(x, y, coverage);
+    };
+    auto fpart = [](double v) { return v - std::floor(v); };
+
+    const double dx = x1 - x0;
+    const double gradient = dx > 1e-9 ? (y1 - y0) / dx : 0;
+
+    double xend = std::round(x0);
+    double yend = y0 + gradient*(xend - x0);
+    double xgap = 1 - fpart(x0 + 0.5);
+    const int xpxl1 = int(xend);
+    if (drawStart)
+    {
+        const int y = int(std::floor(yend));
+        plot(xpxl1, y, (1 - fpart(yend))*xgap);
+        plot(xpxl1, y+1, fpart(yend)*xgap);
+    }
+    double intery = yend + gradient;
+
+    xend = std::round(x1);
+    yend = y1 + gradient*(xend - x1);
+    xgap = fpart(x1 + 0.5);
+    const int xpxl2 = int(xend);
+    if (drawEnd && xpxl2 != xpxl1)
+    {
+        const int y = int(std::floor(yend));
+        plot(xpxl2, y, (1 - fpart(yend))*xgap);
+        plot(xpxl2, y+1, fpart(yend)*xgap);
+    }
+
+    for (int x = xpxl1 + 1; x < xpxl2; x++)
+    {
+        const int y = int(std::floor(intery));
+        plot(x, y, 1 - fpart(intery));
+        plot(x, y+1, fpart(intery));
+        intery += gradient;
+    }
+}
+
+inline bool isGap(const QPointF &p)
+{
+    return qIsNaN(p.x()) || qIsNaN(p.y()) || qIsInf(p.y());
+}
+
+} // namespace
+
+bool drawThinPolyline(QCPPainter *painter, const QVector<QPointF> &lines)
+{
+    if (painter->modes().testFlag(QCPPainter::pmVectorized))
+        return false;
+
+    QPaintDevice *device = painter->device();
+    if (!device || device->devType() != QInternal::Image)
+        return false;
+    QImage *image = static_cast<QImage*>(device);
+    if (image->format() != QImage::Format_ARGB32_Premultiplied && image->format() != QImage::Format_RGB32)
+        return false;
+
+    const QPen pen = painter->pen();
+    if (pen.style() != Qt::SolidLine || pen.brush().style() != Qt::SolidPattern)
+        return false;
+    if (painter->compositionMode() != QPainter::CompositionMode_SourceOver)
+        return false;
+
+    // Device transform includes device pixel ratio scaling
+    const QTransform transform = painter->deviceTransform();
+    if (transform.type() > QTransform::TxScale)
+        return false;
+
+    // Pixels are written one by one, so the line must be 1 device pixel wide. QCPPainter's pens are
+    // non-cosmetic and scaled by the transform, e.g. 1px pen is 2 device pixels wide at 200% screen scaling.
+    if (pen.widthF() != 0 && !pen.isCosmetic())
+    {
+        if (!qFuzzyCompare(pen.widthF() * qAbs(transform.m11()), 1.0) ||
+            !qFuzzyCompare(pen.widthF() * qAbs(transform.m22()), 1.0))
+            return false;
+    }
+    else if (pen.widthF() != 0 && !qFuzzyCompare(pen.widthF(), 1.0))
+        return false;
+
+    QRect clip = image->rect();
+    if (painter->hasClipping())
+    {
+        if (painter->clipRegion().rectCount() > 1)
+            return false;
+        clip &= transform.mapRect(painter->clipBoundingRect()).toAlignedRect();
+    }
+    if (clip.isEmpty())
+        return true;
+
+    QColor color = pen.color();
+    color.setAlphaF(color.alphaF() * painter->opacity());
+    if (color.alpha() == 0)
+        return true;
+
+    // Antialiased segments overlap near joints, so translucent pixels there would be blended twice
+    // and come out darker than in QPainter, which strokes the whole polyline as one path
+    const bool antialiased = painter->testRenderHint(QPainter::Antialiasing);
+    if (antialiased && color.alpha() < 255)
+        return false;
+
+    PixelWriter writer(image, clip, color.rgba());
+    // Segments are clipped with a margin to keep antialiased edges at the clip border intact
+    const QRectF clipF = QRectF(clip).adjusted(-2, -2, 2, 2);
+
+    const int count = lines.size();
+    const QPointF *points = lines.constData();
+    for (int i = 0; i < count - 1; i++)
+    {
+        if (isGap(points[i]) || isGap(points[i+1]))
+            continue;
+        QPointF a = transform.map(points[i]);
+        QPointF b = transform.map(points[i+1]);
+        const bool lastPixel = i+2 >= count || isGap(points[i+2]);
+        if (!clipSegment(a, b, clipF))
+            continue;
+        if (antialiased)
+            drawAntialiasedSegment(writer, a, b, lastPixel);
+        else
+            drawAliasedSegment(writer, a, b, lastPixel);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//                              drawScatterStamps
+//------------------------------------------------------------------------------
+
+namespace {
+
+bool isCacheableBrush(const QBrush &brush)
+{
+    return brush.style() == Qt::NoBrush || brush.style() == Qt::SolidPattern;
+}
+
+QString glyphKey(const QCPScatterStyle &style, const QPen &pen, const QBrush &brush, double scale, bool antialiased, bool nonCosmetic)
+{
+    QString key = QStringLiteral("qcpl_scatter:%1:%2:%3:%4:%5:%6:%7:%8:%9")
+        .arg(int(style.shape())).arg(style.size()).arg(scale).arg(antialiased).arg(nonCosmetic)
+        .arg(pen.color().rgba()).arg(pen.widthF()).arg(int(pen.style())).arg(pen.isCosmetic());
+    key += QStringLiteral(":%1:%2:%3:%4")
+        .arg(int(pen.capStyle())).arg(int(pen.joinStyle())).arg(int(brush.style())).arg(brush.color().rgba());
+    if (style.shape() == QCPScatterStyle::ssCustom)
+    {
+        QByteArray path;
+        QDataStream stream(&path, QIODevice::WriteOnly);
+        stream << style.customPath();
+        key += ':' + QString::number(qHash(path));
+    }
+    return key;
+}
+
+} // namespace
+
+bool drawScatterStamps(QCPPainter *painter, const QVector<QPointF> &scatters, const QCPScatterStyle &style)
+{
+    if (style.isNone() || style.shape() == QCPScatterStyle::ssPixmap)
+        return false;
+    if (painter->modes().testFlag(QCPPainter::pmVectorized))
+        return false;
+    // QPixmapCache is only available in the GUI thread, and e.g. QPicture would store every fragment
+    auto engine = painter->paintEngine();
+    if (!engine || (engine->type() != QPaintEngine::Raster && engine->type() != QPaintEngine::OpenGL2))
+        return false;
+    if (QThread::currentThread() != qApp->thread())
+        return false;
+
+    const QPen pen = painter->pen();
+    const QBrush brush = painter->brush();
+    if (pen.style() == Qt::CustomDashLine || !isCacheableBrush(pen.brush()) || !isCacheableBrush(brush))
+        return false;
+
+    // Glyph is rendered at device scale so that it looks the same as being drawn directly
+    const QTransform transform = painter->deviceTransform();
+    if (transform.type() > QTransform::TxScale || !qFuzzyCompare(transform.m11(), transform.m22()) || transform.m11() <= 0)
+        return false;
+    const double scale = transform.m11();
+
+    const bool antialiased = painter->testRenderHint(QPainter::Antialiasing);
+    const bool nonCosmetic = painter->modes().testFlag(QCPPainter::pmNonCosmetic);
+
+    // Logical size of the glyph square with some room for the pen and antialiasing
+    double extent = style.size() + 2*qMax(1.0, pen.widthF()) + 2;
+    if (style.shape() == QCPScatterStyle::ssCustom)
+    {
+        // QCPScatterStyle::drawShape() scales custom path together with its pen by size/6
+        const double pathScale = style.size()/6.0;
+        const QRectF bounds = style.customPath().boundingRect();
+        const double pathExtent = 2*qMax(qMax(qAbs(bounds.left()), qAbs(bounds.right())), qMax(qAbs(bounds.top()), qAbs(bounds.bottom())));
+        extent = (pathExtent + 2*qMax(1.0, pen.widthF()))*pathScale + 2;
+    }
+    const int glyphPixels = qCeil(extent*scale);
+    if (glyphPixels > 256)
+        return false;
+
+    const QString key = glyphKey(style, pen, brush, scale, antialiased, nonCosmetic);
+    QPixmap glyph;
+    if (!QPixmapCache::find(key, &glyph))
+    {
+        glyph = QPixmap(glyphPixels, glyphPixels);
+        glyph.fill(Qt::transparent);
+        QCPPainter glyphPainter(&glyph);
+        glyphPainter.setMode(QCPPainter::pmNonCosmetic, nonCosmetic);
+        glyphPainter.setRenderHint(QPainter::Antialiasing, antialiased);
+        glyphPainter.scale(scale, scale);
+        glyphPainter.setPen(pen);
+        glyphPainter.setBrush(brush);
+        style.drawShape(&glyphPainter, glyphPixels/scale/2.0, glyphPixels/scale/2.0);
+        glyphPainter.end();
+        QPixmapCache::insert(key, glyph);
+    }
+
+    // Fragments are positioned by their centers, which are snapped so the glyph lands on whole device pixels
+    // and all the markers look exactly the same. Glyph pixels are device pixels, hence scaling by 1/scale
+    const QRectF source(0, 0, glyphPixels, glyphPixels);
+    const double half = glyphPixels/2.0;
+    const double dx = transform.dx(), dy = transform.dy();
+    QVector<QPainter::PixmapFragment> fragments;
+    fragments.reserve(scatters.size());
+    for (const QPointF &p : scatters)
+    {
+        if (!qIsFinite(p.x()) || !qIsFinite(p.y()))
+            continue;
+        const double x = (std::round(p.x()*scale + dx - half) + half - dx)/scale;
+        const double y = (std::round(p.y()*scale + dy - half) + half - dy)/scale;
+        fragments << QPainter::PixmapFragment::create(QPointF(x, y), source, 1/scale, 1/scale);
+    }
+    painter->drawPixmapFragments(fragments.constData(), fragments.size(), glyph);
+    return true;
+}
+
+} // namespace QCPL
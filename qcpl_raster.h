@@ -0,0 +1,47 @@
+#ifndef QCPL_RASTER_H
+#define QCPL_RASTER_H
+
+#include "qcustomplot/qcustomplot.h"
+
+namespace QCPL {
+
+/**
+    Paint buffer keeping layer pixels in QImage instead of QPixmap,
+    so that the pixels can be accessed directly by drawThinPolyline().
+*/
+class ImagePaintBuffer : public QCPAbstractPaintBuffer
+{
+public:
+    explicit ImagePaintBuffer(const QSize &size, double devicePixelRatio);
+
+    QCPPainter *startPainting() override;
+    void draw(QCPPainter *painter) const override;
+    void clear(const QColor &color) override;
+
+protected:
+    void reallocateBuffer() override;
+
+private:
+    QImage _buffer;
+};
+
+/// Draws a polyline of solid pen 1 device pixel wide writing pixels right into the painter's target image,
+/// bypassing the generic raster engine. Lines are antialiased if the painter has the antialiasing hint.
+/// NaN points make gaps in the line, like QCPAbstractPlottable1D::drawPolyline() does.
+/// Returns false without drawing anything when the painter state can't be handled,
+/// e.g. a wide (also 1px pen scaled by device pixel ratio), dashed, or gradient pen, non-image device,
+/// rotation, non-default composition mode, or translucent color with antialiasing,
+/// then the line should be drawn as usual.
+bool drawThinPolyline(QCPPainter *painter, const QVector<QPointF> &lines);
+
+/// Draws scatters by stamping a glyph rendered once per scatter style, pen, brush, and device scale.
+/// Glyphs are kept in QPixmapCache and all the points are blitted in one QPainter::drawPixmapFragments() call.
+/// The painter should be already prepared with QCPScatterStyle::applyTo().
+/// Returns false without drawing anything when the glyph can't be cached,
+/// e.g. for vector export, painting to a picture, rotated transform, or gradient brush,
+/// then the shapes should be drawn one by one as usual.
+bool drawScatterStamps(QCPPainter *painter, const QVector<QPointF> &scatters, const QCPScatterStyle &style);
+
+} // namespace QCPL
+
+#endif // QCPL_RASTER_H
@@ -0,0 +1,208 @@
+#include "qcpl_render.h"
+
+#include "qcpl_export.h"
+#include "qcpl_plot.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QPicture>
+#include <QRegularExpression>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+
+namespace QCPL {
+
+namespace {
+
+/// Recordings waiting for a free pool thread, per thread
+const int queuedRecordingsPerThread = 2;
+
+bool setupPlot(Plot *plot, const RenderJob &job, RenderResult *result)
+{
+    if (job.width <= 0 || job.height <= 0)
+    {
+        result->error = QString("Invalid image size %1x%2").arg(job.width).arg(job.height);
+        return false;
+    }
+    for (const auto &graph : job.graphs)
+    {
+        auto g = plot->makeNewGraph(graph.title, graph.data, false);
+        if (graph.format.isEmpty()) continue;
+        if (auto err = readGraph(graph.format, g); !err.ok())
+            result->warnings << err.message;
+    }
+    if (!job.format.isEmpty())
+    {
+        JsonReport report;
+        readPlot(job.format, plot, &report, job.formatOptions);
+        for (const auto &err : std::as_const(report))
+            result->warnings << err.message;
+    }
+    if (!job.formatOptions.axesLimits)
+        plot->autolimits(false);
+    return true;
+}
+
+void saveImage(const QImage &image, const RenderJob &job, RenderResult *result)
+{
+    if (job.fileName.isEmpty())
+        result->image = image;
+    else if (!image.save(job.fileName))
+        result->error = "Unable to save image " + job.fileName;
+}
+
+bool readColumns(const QString &fileName, GraphData &data, QString &error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        error = QString("Unable to open data file %1: %2").arg(fileName, file.errorString());
+        return false;
+    }
+    static const QRegularExpression separators("[\\s,;]+");
+    QTextStream stream(&file);
+    while (!stream.atEnd())
+    {
+        const QString line = stream.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) continue;
+        const QStringList parts = line.split(separators, Qt::SkipEmptyParts);
+        if (parts.size() < 2) continue;
+        bool okX, okY;
+        const double x = parts.at(0).toDouble(&okX);
+        const double y = parts.at(1).toDouble(&okY);
+        // Column headers and other text lines are skipped
+        if (!okX || !okY) continue;
+        data.x << x;
+        data.y << y;
+    }
+    return true;
+}
+
+ValueArray jsonToValues(const QJsonValue &value)
+{
+    const QJsonArray array = value.toArray();
+    ValueArray values;
+    values.reserve(array.size());
+    for (const auto &v : array)
+        values << v.toDouble(qQNaN());
+    return values;
+}
+
+} // namespace
+
+RenderResult renderPlot(const RenderJob &job)
+{
+    RenderResult result;
+    Plot plot;
+    if (!setupPlot(&plot, job, &result))
+        return result;
+    const QImage image = renderPlotImage(&plot, job.width, job.height);
+    if (image.isNull())
+        result.error = QString("Unable to make image of size %1x%2").arg(job.width).arg(job.height);
+    else
+        saveImage(image, job, &result);
+    return result;
+}
+
+QVector<RenderResult> renderPlots(const QVector<RenderJob> &jobs, int threadCount)
+{
+    QVector<RenderResult> results(jobs.size());
+    if (jobs.isEmpty())
+        return results;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount > 0 ? threadCount : QThread::idealThreadCount());
+    QSemaphore freeSlots(queuedRecordingsPerThread * pool.maxThreadCount());
+
+    RenderResult *result = results.data();
+    for (const RenderJob &job : jobs)
+    {
+        RenderResult *jobResult = result++;
+
+        // Plots can only be painted in the GUI thread, so the painting is recorded here
+        // and the pool threads play it into images, the same as renderPlotImage() does with bands
+        QByteArray recording;
+        {
+            Plot plot;
+            if (!setupPlot(&plot, job, jobResult))
+                continue;
+            QPicture picture;
+            QCPPainter painter(&picture);
+            plot.toPainter(&painter, job.width, job.height);
+            painter.end();
+            recording = QByteArray(picture.data(), int(picture.size()));
+        }
+
+        freeSlots.acquire();
+        pool.start(QRunnable::create([&job, jobResult, &freeSlots, recording]{
+            QImage image(job.width, job.height, QImage::Format_RGB32);
+            if (image.isNull())
+                jobResult->error = QString("Unable to make image of size %1x%2").arg(job.width).arg(job.height);
+            else
+            {
+                QPicture picture;
+                picture.setData(recording.constData(), uint(recording.size()));
+                QPainter painter(&image);
+                painter.drawPicture(0, 0, picture);
+                painter.end();
+                saveImage(image, job, jobResult);
+            }
+            freeSlots.release();
+        }));
+    }
+    pool.waitForDone();
+    return results;
+}
+
+QString readRenderJob(const QString &fileName, RenderJob &job)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return "Unable to open file for reading: " + file.errorString();
+
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    if (doc.isNull())
+        return "Unable to parse json file: " + error.errorString();
+
+    const QJsonObject root = doc.object();
+    job.width = root["width"].toInt(job.width);
+    job.height = root["height"].toInt(job.height);
+    job.format = root["format"].toObject();
+    job.formatOptions.titleText = root["title_text"].toBool(job.formatOptions.titleText);
+    job.formatOptions.axesTexts = root["axes_texts"].toBool(job.formatOptions.axesTexts);
+    job.formatOptions.axesLimits = root["axes_limits"].toBool(job.formatOptions.axesLimits);
+
+    const QDir dir = QFileInfo(fileName).absoluteDir();
+    const QJsonArray graphs = root["graphs"].toArray();
+    for (const auto &it : graphs)
+    {
+        const QJsonObject obj = it.toObject();
+        RenderGraph graph;
+        graph.title = obj["title"].toString();
+        graph.format = obj["format"].toObject();
+        if (obj.contains("file"))
+        {
+            QString err;
+            if (!readColumns(dir.absoluteFilePath(obj["file"].toString()), graph.data, err))
+                return err;
+        }
+        else
+        {
+            graph.data.x = jsonToValues(obj["x"]);
+            graph.data.y = jsonToValues(obj["y"]);
+            if (graph.data.x.size() != graph.data.y.size())
+                return QString("Graph \"%1\" has different number of x and y values").arg(graph.title);
+        }
+        job.graphs << graph;
+    }
+    return {};
+}
+
+} // namespace QCPL
@@ -0,0 +1,81 @@
+#ifndef QCPL_RENDER_H
+#define QCPL_RENDER_H
+
+#include "qcpl_io_json.h"
+#include "qcpl_types.h"
+
+#include <QImage>
+#include <QJsonObject>
+#include <QStringList>
+
+namespace QCPL {
+
+struct RenderGraph
+{
+    QString title;
+    GraphData data;
+
+    /// Line format as made by writeGraph(), optional
+    QJsonObject format;
+};
+
+/// Everything needed to render a plot without any visible widget
+struct RenderJob
+{
+    /// Plot format as made by writePlot(), optional
+    QJsonObject format;
+    ReadPlotOptions formatOptions;
+
+    QVector<RenderGraph> graphs;
+
+    /// Image size in pixels
+    int width = 800;
+    int height = 600;
+
+    /// When set, the image is saved into this file and not returned in RenderResult
+    QString fileName;
+};
+
+struct RenderResult
+{
+    QImage image;
+    QString error;
+
+    /// Non critical problems, e.g. unsupported format versions
+    QStringList warnings;
+
+    bool ok() const { return error.isEmpty(); }
+};
+
+/// Builds a plot for the job and renders it, large images are painted by several threads, see renderPlotImage().
+/// Must be called in the GUI thread, because the plot is still a widget, though it's never shown.
+RenderResult renderPlot(const RenderJob &job);
+
+/// Renders many jobs in parallel. Plots are built and their painting is recorded one by one in the calling
+/// GUI thread, and the recordings are played into images and saved into files by @a threadCount pool threads
+/// (the ideal thread count when zero). The GUI thread never goes far ahead of the pool, so only a few
+/// recordings are kept in memory at once. Works with the `offscreen` QPA platform.
+QVector<RenderResult> renderPlots(const QVector<RenderJob> &jobs, int threadCount = 0);
+
+/**
+    Reads a render job from JSON file:
+    @code
+    {
+        "width": 1200,
+        "height": 800,
+        "format": { ...writePlot() output... },
+        "title_text": true, "axes_texts": true, "axes_limits": false,
+        "graphs": [
+            { "title": "Inline", "x": [0, 1, 2], "y": [1, 4, 9], "format": { ...writeGraph() output... } },
+            { "title": "External", "file": "data.txt" }
+        ]
+    }
+    @endcode
+    External data files contain two columns of numbers separated by spaces, commas or semicolons,
+    their paths are relative to the job file. Returns empty string when succeeded or error message otherwise.
+*/
+QString readRenderJob(const QString &fileName, RenderJob &job);
+
+} // namespace QCPL
+
+#endif // QCPL_RENDER_H
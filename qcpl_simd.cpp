@@ -0,0 +1,276 @@
+#include "qcpl_simd.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QCPL_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX code is compiled with the target attribute and is only called when the CPU supports it,
+// so the library itself doesn't require AVX-enabled compiler flags
+#if defined(QCPL_SIMD_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define QCPL_SIMD_AVX
+#include <immintrin.h>
+#endif
+
+namespace QCPL {
+
+static_assert(sizeof(QCPGraphData) == 2*sizeof(double), "QCPGraphData is expected to be a pair of doubles");
+
+namespace {
+
+struct Accumulator
+{
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    inline void add(double v)
+    {
+        if (!std::isfinite(v)) return;
+        if (v < min) min = v;
+        if (v > max) max = v;
+    }
+
+    inline void merge(const double *mins, const double *maxs, int count)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (mins[i] < min) min = mins[i];
+            if (maxs[i] > max) max = maxs[i];
+        }
+    }
+};
+
+void scalarMinMax(const double *data, int count, int stride, QCP::SignDomain signDomain, double threshold, Accumulator &acc)
+{
+    switch (signDomain)
+    {
+    case QCP::sdBoth:
+        for (int i = 0; i < count; i++)
+            acc.add(data[i*stride]);
+        break;
+    case QCP::sdPositive:
+        for (int i = 0; i < count; i++)
+            if (data[i*stride] > threshold)
+                acc.add(data[i*stride]);
+        break;
+    case QCP::sdNegative:
+        for (int i = 0; i < count; i++)
+            if (data[i*stride] < threshold)
+                acc.add(data[i*stride]);
+        break;
+    }
+}
+
+void scalarLookup(const double *data, int count, int stride, double lower, double factor,
+                  const QRgb *lut, int lutSize, QRgb nanColor, QRgb *colors)
+{
+    const double maxIndex = lutSize - 1;
+    for (int i = 0; i < count; i++)
+    {
+        const double v = data[i*stride];
+        if (std::isnan(v))
+        {
+            colors[i] = nanColor;
+            continue;
+        }
+        // Written so that NaN index (zero factor by infinite value) goes to the first color
+        const double index = (v - lower) * factor;
+        colors[i] = lut[index > 0 ? int(qMin(index, maxIndex)) : 0];
+    }
+}
+
+#ifdef QCPL_SIMD_SSE2
+
+// Non-finite values and values out of the sign domain are replaced with infinities not affecting the result.
+// Both functions return the number of processed values, the tail is left for the scalar code.
+
+int sse2MinMax(const double *data, int count, int stride, QCP::SignDomain signDomain, double threshold, Accumulator &acc)
+{
+    const __m128d inf = _mm_set1_pd(std::numeric_limits<double>::infinity());
+    const __m128d negInf = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+    const __m128d t = _mm_set1_pd(threshold);
+    const __m128d signBit = _mm_set1_pd(-0.0);
+    __m128d min = inf, max = negInf;
+    int i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        // In the strided case two {key, value} points are loaded and values are collected from the high halves
+        const __m128d v = stride == 1
+            ? _mm_loadu_pd(data + i)
+            : _mm_unpackhi_pd(_mm_loadu_pd(data - 1 + i*2), _mm_loadu_pd(data + 1 + i*2));
+        // NaN fails the comparison and is masked out too
+        __m128d mask = _mm_cmplt_pd(_mm_andnot_pd(signBit, v), inf);
+        if (signDomain == QCP::sdPositive)
+            mask = _mm_and_pd(mask, _mm_cmpgt_pd(v, t));
+        else if (signDomain == QCP::sdNegative)
+            mask = _mm_and_pd(mask, _mm_cmplt_pd(v, t));
+        min = _mm_min_pd(_mm_or_pd(_mm_and_pd(mask, v), _mm_andnot_pd(mask, inf)), min);
+        max = _mm_max_pd(_mm_or_pd(_mm_and_pd(mask, v), _mm_andnot_pd(mask, negInf)), max);
+    }
+    double lo[2], hi[2];
+    _mm_storeu_pd(lo, min);
+    _mm_storeu_pd(hi, max);
+    acc.merge(lo, hi, 2);
+    return i;
+}
+
+// Indices are calculated and bounded in vector registers, there are no gathers in SSE2 so colors are taken one by one.
+// MAXPD returns its second operand when any of them is NaN, so NaN indices go to the first color like in scalarLookup().
+int sse2Lookup(const double *data, int count, double lower, double factor,
+               const QRgb *lut, int lutSize, QRgb nanColor, QRgb *colors)
+{
+    const __m128d lo = _mm_set1_pd(lower);
+    const __m128d f = _mm_set1_pd(factor);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d maxIndex = _mm_set1_pd(lutSize - 1);
+    alignas(16) qint32 indices[4];
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128d v0 = _mm_loadu_pd(data + i);
+        const __m128d v1 = _mm_loadu_pd(data + i + 2);
+        // NaN values are rare, so the whole quad is processed by the scalar code then
+        if (_mm_movemask_pd(_mm_or_pd(_mm_cmpunord_pd(v0, v0), _mm_cmpunord_pd(v1, v1))))
+        {
+            scalarLookup(data + i, 4, 1, lower, factor, lut, lutSize, nanColor, colors + i);
+            continue;
+        }
+        const __m128d x0 = _mm_min_pd(_mm_max_pd(_mm_mul_pd(_mm_sub_pd(v0, lo), f), zero), maxIndex);
+        const __m128d x1 = _mm_min_pd(_mm_max_pd(_mm_mul_pd(_mm_sub_pd(v1, lo), f), zero), maxIndex);
+        _mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_unpacklo_epi64(_mm_cvttpd_epi32(x0), _mm_cvttpd_epi32(x1)));
+        colors[i] = lut[indices[0]];
+        colors[i+1] = lut[indices[1]];
+        colors[i+2] = lut[indices[2]];
+        colors[i+3] = lut[indices[3]];
+    }
+    return i;
+}
+
+#endif // QCPL_SIMD_SSE2
+
+#ifdef QCPL_SIMD_AVX
+
+__attribute__((target("avx")))
+int avxMinMax(const double *data, int count, int stride, QCP::SignDomain signDomain, double threshold, Accumulator &acc)
+{
+    const __m256d inf = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+    const __m256d negInf = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+    const __m256d t = _mm256_set1_pd(threshold);
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    __m256d min = inf, max = negInf;
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        // In the strided case four {key, value} points are loaded, the value order doesn't matter for min/max
+        const __m256d v = stride == 1
+            ? _mm256_loadu_pd(data + i)
+            : _mm256_unpackhi_pd(_mm256_loadu_pd(data - 1 + i*2), _mm256_loadu_pd(data + 3 + i*2));
+        // NaN fails the ordered comparison and is masked out too
+        __m256d mask = _mm256_cmp_pd(_mm256_andnot_pd(signBit, v), inf, _CMP_LT_OQ);
+        if (signDomain == QCP::sdPositive)
+            mask = _mm256_and_pd(mask, _mm256_cmp_pd(v, t, _CMP_GT_OQ));
+        else if (signDomain == QCP::sdNegative)
+            mask = _mm256_and_pd(mask, _mm256_cmp_pd(v, t, _CMP_LT_OQ));
+        min = _mm256_min_pd(_mm256_blendv_pd(inf, v, mask), min);
+        max = _mm256_max_pd(_mm256_blendv_pd(negInf, v, mask), max);
+    }
+    double lo[4], hi[4];
+    _mm256_storeu_pd(lo, min);
+    _mm256_storeu_pd(hi, max);
+    _mm256_zeroupper();
+    acc.merge(lo, hi, 4);
+    return i;
+}
+
+__attribute__((target("avx2")))
+int avx2Lookup(const double *data, int count, double lower, double factor,
+               const QRgb *lut, int lutSize, QRgb nanColor, QRgb *colors)
+{
+    const __m256d lo = _mm256_set1_pd(lower);
+    const __m256d f = _mm256_set1_pd(factor);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d maxIndex = _mm256_set1_pd(lutSize - 1);
+    const int *table = reinterpret_cast<const int*>(lut);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256d v0 = _mm256_loadu_pd(data + i);
+        const __m256d v1 = _mm256_loadu_pd(data + i + 4);
+        if (_mm256_movemask_pd(_mm256_or_pd(_mm256_cmp_pd(v0, v0, _CMP_UNORD_Q), _mm256_cmp_pd(v1, v1, _CMP_UNORD_Q))))
+        {
+            scalarLookup(data + i, 8, 1, lower, factor, lut, lutSize, nanColor, colors + i);
+            continue;
+        }
+        // Same as in sse2Lookup(), VMAXPD returns the second operand for NaN indices
+        const __m256d x0 = _mm256_min_pd(_mm256_max_pd(_mm256_mul_pd(_mm256_sub_pd(v0, lo), f), zero), maxIndex);
+        const __m256d x1 = _mm256_min_pd(_mm256_max_pd(_mm256_mul_pd(_mm256_sub_pd(v1, lo), f), zero), maxIndex);
+        const __m256i indices = _mm256_set_m128i(_mm256_cvttpd_epi32(x1), _mm256_cvttpd_epi32(x0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(colors + i), _mm256_i32gather_epi32(table, indices, 4));
+    }
+    _mm256_zeroupper();
+    return i;
+}
+
+bool hasAvx()
+{
+    static const bool avx = __builtin_cpu_supports("avx");
+    return avx;
+}
+
+bool hasAvx2()
+{
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+#endif // QCPL_SIMD_AVX
+
+} // namespace
+
+bool findMinMax(const double *data, int count, int stride, QCP::SignDomain signDomain, double &min, double &max, double threshold)
+{
+    Accumulator acc;
+    int done = 0;
+    if (stride == 1 || stride == 2)
+    {
+#if defined(QCPL_SIMD_AVX)
+        if (hasAvx())
+            done = avxMinMax(data, count, stride, signDomain, threshold, acc);
+        else
+            done = sse2MinMax(data, count, stride, signDomain, threshold, acc);
+#elif defined(QCPL_SIMD_SSE2)
+        done = sse2MinMax(data, count, stride, signDomain, threshold, acc);
+#endif
+    }
+    scalarMinMax(data + done*stride, count - done, stride, signDomain, threshold, acc);
+    min = acc.min;
+    max = acc.max;
+    return min <= max;
+}
+
+bool findMinMax(const QCPGraphData *data, int count, QCP::SignDomain signDomain, double &min, double &max)
+{
+    return findMinMax(&data->value, count, 2, signDomain, min, max);
+}
+
+void lookupColors(const double *data, int count, int stride, double lower, double factor,
+                  const QRgb *lut, int lutSize, QRgb nanColor, QRgb *colors)
+{
+    int done = 0;
+    if (stride == 1)
+    {
+#if defined(QCPL_SIMD_AVX)
+        if (hasAvx2())
+            done = avx2Lookup(data, count, lower, factor, lut, lutSize, nanColor, colors);
+        else
+            done = sse2Lookup(data, count, lower, factor, lut, lutSize, nanColor, colors);
+#elif defined(QCPL_SIMD_SSE2)
+        done = sse2Lookup(data, count, lower, factor, lut, lutSize, nanColor, colors);
+#endif
+    }
+    scalarLookup(data + done*stride, count - done, stride, lower, factor, lut, lutSize, nanColor, colors + done);
+}
+
+} // namespace QCPL
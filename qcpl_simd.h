@@ -0,0 +1,27 @@
+#ifndef QCPL_SIMD_H
+#define QCPL_SIMD_H
+
+#include "qcustomplot/qcustomplot.h"
+
+namespace QCPL {
+
+/// Finds min and max of @a count doubles starting at @a data and taken with @a stride (in doubles).
+/// NaNs and infinities are skipped the same way as QCPDataContainer::valueRange() does.
+/// With sdPositive only values above @a threshold are accounted, with sdNegative only values below it.
+/// Returns false if there are no suitable values, @a min and @a max are undefined then.
+/// Stride 1 (separate value arrays) and 2 (values of QCPGraphData) use SSE2 or AVX when the CPU supports it.
+bool findMinMax(const double *data, int count, int stride, QCP::SignDomain signDomain, double &min, double &max, double threshold = 0);
+
+/// Finds min and max of values of the given graph points, see findMinMax().
+bool findMinMax(const QCPGraphData *data, int count, QCP::SignDomain signDomain, double &min, double &max);
+
+/// Maps @a count doubles starting at @a data and taken with @a stride (in doubles) to colors of the lookup table
+/// @a lut of @a lutSize items the same way as non-periodic linear QCPColorGradient::colorize() does:
+/// the index is (value - @a lower) * @a factor bounded to the table, NaNs get @a nanColor.
+/// Stride 1 uses SSE2, or AVX2 gathers when the CPU supports them.
+void lookupColors(const double *data, int count, int stride, double lower, double factor,
+                  const QRgb *lut, int lutSize, QRgb nanColor, QRgb *colors);
+
+} // namespace QCPL
+
+#endif // QCPL_SIMD_H
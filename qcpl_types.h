@@ -17,6 +17,14 @@ template <typename T> struct XYPair
 
 typedef XYPair<ValueArray> GraphData;
 
+/// Graph points kept in their native sample types, e.g. float or 16-bit ADC counts.
+/// They are converted to double only when mapped to pixels, see TypedGraphData.
+template <typename KeyT, typename ValueT> struct GraphDataT
+{
+    QVector<KeyT> x;
+    QVector<ValueT> y;
+};
+
 struct AxisLimits
 {
     double min;
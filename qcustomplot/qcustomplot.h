@@ -2633,6 +2633,7 @@ public:
   void add(const QVector<DataType> &data, bool alreadySorted=false);
   void add(const DataType &data);
   void removeBefore(double sortKey);
+  void removeFirst(int count);
   void removeAfter(double sortKey);
   void remove(double sortKeyFrom, double sortKeyTo);
   void remove(double sortKey);
@@ -2970,6 +2971,19 @@ void QCPDataContainer<DataType>::removeBefore(double sortKey)
     performAutoSqueeze();
 }
 
+/*!
+  Removes the first \a count data points regardless of their (sort-)keys.
+
+  \see removeBefore
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::removeFirst(int count)
+{
+  mPreallocSize += qBound(0, count, size()); // same as in removeBefore, the points just join the preallocated block
+  if (mAutoSqueeze)
+    performAutoSqueeze();
+}
+
 /*!
   Removes all data points with (sort-)keys greater than or equal to \a sortKey.
 
@@ -4042,10 +4056,11 @@ protected:
   QList<QCPLayerable*> layerableListAt(const QPointF &pos, bool onlySelectable, QList<QVariant> *selectionDetails=nullptr) const;
   void drawBackground(QCPPainter *painter);
   void setupPaintBuffers();
-  QCPAbstractPaintBuffer *createPaintBuffer();
+  virtual QCPAbstractPaintBuffer *createPaintBuffer();
   bool hasInvalidatedPaintBuffers();
   bool setupOpenGl();
   void freeOpenGl();
+  void detachFromLayers(const QSet<QCPLayerable*> &layerables);
   
   friend class QCPLegend;
   friend class QCPAxis;
@@ -4058,6 +4073,33 @@ protected:
 Q_DECLARE_METATYPE(QCustomPlot::LayerInsertMode)
 Q_DECLARE_METATYPE(QCustomPlot::RefreshPriority)
 
+/*! \internal
+
+  Removes \a layerables from their layers in one pass per layer, so deleting many layerables
+  afterwards doesn't call QCPLayer::removeChild (a linear search) for each of them.
+*/
+inline void QCustomPlot::detachFromLayers(const QSet<QCPLayerable*> &layerables)
+{
+  QSet<QCPLayer*> layers;
+  foreach (QCPLayerable *layerable, layerables)
+  {
+    if (layerable->mLayer)
+      layers.insert(layerable->mLayer);
+    layerable->mLayer = nullptr;
+  }
+  foreach (QCPLayer *layer, layers)
+  {
+    QList<QCPLayerable*> children;
+    children.reserve(layer->mChildren.size());
+    foreach (QCPLayerable *child, layer->mChildren)
+      if (!layerables.contains(child))
+        children.append(child);
+    layer->mChildren = children;
+    if (QSharedPointer<QCPAbstractPaintBuffer> pb = layer->mPaintBuffer.toStrongRef())
+      pb->setInvalidated();
+  }
+}
+
 
 // implementation of template functions:
 
@@ -6038,6 +6080,9 @@ public:
   double data(double key, double value);
   double cell(int keyIndex, int valueIndex);
   unsigned char alpha(int keyIndex, int valueIndex);
+  const double *rawData() const { return mData; }
+  const unsigned char *rawAlpha() const { return mAlpha; }
+  bool isDataModified() const { return mDataModified; }
   
   // setters:
   void setSize(int keySize, int valueSize);
@@ -6049,6 +6094,7 @@ public:
   void setData(double key, double value, double z);
   void setCell(int keyIndex, int valueIndex, double z);
   void setAlpha(int keyIndex, int valueIndex, unsigned char alpha);
+  void setDataModified(bool modified) { mDataModified = modified; }
   
   // non-property methods:
   void recalculateDataBounds();
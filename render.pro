@@ -0,0 +1,14 @@
+QT += core gui widgets
+
+include("custom-plot-lab.pri")
+
+# orion (https://github.com/orion-project/orion-qt)
+include($$_PRO_FILE_PWD_/orion/orion.pri)
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = qcpl-render
+
+SOURCES += \
+    render_main.cpp
@@ -0,0 +1,88 @@
+#include "qcpl_render.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+/// Jobs are read and rendered by portions, so their data is not loaded all at once
+const int jobsPerPortion = 64;
+
+int main(int argc, char *argv[])
+{
+    // Plots are widgets, so the application is required, though nothing is shown
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    app.setApplicationName("qcpl-render");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders plot jobs (*.json files) from a directory into PNG images.\n"
+                                     "See QCPL::readRenderJob() for the job file format.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("jobs", "Directory of job files.");
+    parser.addPositionalArgument("output", "Directory for images, the jobs directory by default.", "[output]");
+    QCommandLineOption threadsOption({"j", "threads"}, "Number of rendering threads, the ideal thread count by default.", "count");
+    parser.addOption(threadsOption);
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.isEmpty())
+        parser.showHelp(1);
+
+    QDir jobsDir(args.at(0));
+    if (!jobsDir.exists())
+    {
+        qWarning().noquote() << "Jobs directory doesn't exist:" << args.at(0);
+        return 1;
+    }
+    QDir outputDir(args.size() > 1 ? args.at(1) : args.at(0));
+    if (!outputDir.mkpath("."))
+    {
+        qWarning().noquote() << "Unable to create output directory:" << outputDir.path();
+        return 1;
+    }
+    const int threadCount = parser.value(threadsOption).toInt();
+
+    QElapsedTimer timer;
+    timer.start();
+    const QStringList files = jobsDir.entryList({"*.json"}, QDir::Files, QDir::Name);
+    int failed = 0;
+    for (int start = 0; start < files.size(); start += jobsPerPortion)
+    {
+        QVector<QCPL::RenderJob> jobs;
+        QStringList names;
+        for (int i = start; i < qMin(start + jobsPerPortion, files.size()); i++)
+        {
+            const QString &name = files.at(i);
+            QCPL::RenderJob job;
+            auto err = QCPL::readRenderJob(jobsDir.filePath(name), job);
+            if (!err.isEmpty())
+            {
+                qWarning().noquote() << name << ":" << err;
+                failed++;
+                continue;
+            }
+            job.fileName = outputDir.filePath(QFileInfo(name).completeBaseName() + ".png");
+            jobs << job;
+            names << name;
+        }
+        const auto results = QCPL::renderPlots(jobs, threadCount);
+        for (int i = 0; i < results.size(); i++)
+        {
+            const auto &result = results.at(i);
+            for (const auto &warning : result.warnings)
+                qWarning().noquote() << names.at(i) << ": warning:" << warning;
+            if (!result.ok())
+            {
+                qWarning().noquote() << names.at(i) << ":" << result.error;
+                failed++;
+            }
+        }
+    }
+    qInfo().noquote() << QString("Rendered %1 of %2 jobs in %3 s")
+        .arg(files.size() - failed).arg(files.size()).arg(timer.elapsed() / 1000.0);
+    return failed > 0 ? 1 : 0;
+}